@@ -0,0 +1,867 @@
+/*
+Copyright (c) 2026 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "shim.h"
+#include "../src/timemeas.h"
+#include "../src/debounce.h"
+#include "../src/choreo.h"
+#include "../src/choreo_keyframes.h"
+#include "../src/pinlatch.h"
+#include "../src/gamma.h"
+
+// Micro-benchmarks for the hot paths of the shared AVR modules, on the host.
+//
+// Each benchmark runs a scripted load against the virtual ATtiny85 (shim.c):
+// a number of main-loop passes per virtual millisecond, for a number of
+// virtual milliseconds. Only the calls under test are timed, advancing the
+// virtual clock is not. The absolute numbers are host numbers, compare them
+// between revisions, not with the ATtiny85.
+
+typedef struct
+{
+    const char *name;
+    uint32_t calls;
+    uint64_t ns;
+    uint32_t events; // benchmark specific, e.g. state changes or choreo steps
+    const char *events_name;
+} result;
+
+// Failed checks of all benchmarks, the exit code is 1 if any
+static uint32_t check_errors = 0;
+
+static uint64_t ns_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void report(const result *res)
+{
+    printf("%-26s %10u calls %9.2f ns/call %10u %s\n",
+           res->name,
+           res->calls,
+           res->calls ? (double)res->ns / res->calls : 0.0,
+           res->events,
+           res->events_name);
+}
+
+static void setup(void)
+{
+    host_reset();
+    timemeas_init();
+    sei();
+}
+
+// Load: main loop polling the time, like the timemeas example
+static void bench_timemeas_now(uint32_t passes_per_ms, uint32_t duration_ms)
+{
+    result res = {"timemeas_now", 0, 0, 0, "ms elapsed"};
+    volatile uint32_t sink = 0;
+
+    setup();
+    for (uint32_t ms = 0; ms < duration_ms; ms++)
+    {
+        uint64_t t0 = ns_now();
+        for (uint32_t i = 0; i < passes_per_ms; i++)
+        {
+            sink = timemeas_now();
+        }
+        res.ns += ns_now() - t0;
+        res.calls += passes_per_ms;
+        host_advance_ms(1);
+    }
+    res.events = sink;
+
+    report(&res);
+}
+
+// Load: fine grained polling, with interrupts disabled for 0.5ms out of 2ms,
+// around a compare match, so that it is pending for a while. Checks the result
+// against the virtual clock.
+static void bench_timemeas_now_us(uint32_t duration_ms)
+{
+    result res = {"timemeas_now_us", 0, 0, 0, "us max. error"};
+    const uint32_t cycles_per_us = F_CPU / 1000000UL;
+
+    setup();
+    // timemeas keeps counting across benchmarks
+    const uint32_t start_us = timemeas_now_us();
+
+    for (uint32_t us = 0; us < duration_ms * 1000; us += 5)
+    {
+        if (us % 2000 == 700)
+        {
+            cli();
+        }
+        else if (us % 2000 == 1200)
+        {
+            sei();
+        }
+
+        uint64_t t0 = ns_now();
+        uint32_t now_us = timemeas_now_us();
+        res.ns += ns_now() - t0;
+        res.calls++;
+
+        uint32_t expected_us = start_us + host_cycles() / cycles_per_us;
+        uint32_t error = (now_us > expected_us) ? now_us - expected_us : expected_us - now_us;
+        if (error > res.events)
+        {
+            res.events = error;
+        }
+
+        host_advance_cycles(5 * cycles_per_us);
+    }
+    sei();
+
+    report(&res);
+}
+
+// Load: main loop sleeping between toggles, like the states example.
+// Counts the interrupts (CPU wake-ups) per toggle and checks the wake-up time
+// against the virtual clock. Build with TIMEMEAS_TICKLESS to compare.
+static void bench_timemeas_sleep_until(uint32_t period_ms, uint32_t duration_ms)
+{
+#ifdef TIMEMEAS_TICKLESS
+    result res = {"timemeas_sleep (tickless)", 0, 0, 0, "irqs/period"};
+#else
+    result res = {"timemeas_sleep_until", 0, 0, 0, "irqs/period"};
+#endif
+    const uint32_t cycles_per_ms = F_CPU / 1000UL;
+    uint32_t max_late_ms = 0;
+
+    setup();
+    const uint32_t start_ms = timemeas_now();
+    uint32_t wake = start_ms;
+
+    for (uint32_t ms = 0; ms < duration_ms; ms += period_ms)
+    {
+        wake += period_ms;
+
+        uint64_t t0 = ns_now();
+        timemeas_sleep_until(wake);
+        res.ns += ns_now() - t0; // includes the virtual clock, compare with care
+        res.calls++;
+
+        uint32_t now_ms = timemeas_now();
+        uint32_t clock_ms = start_ms + host_cycles() / cycles_per_ms;
+        if (now_ms != clock_ms || (int32_t)(now_ms - wake) < 0)
+        {
+            printf("timemeas_sleep_until: woke at %u (clock %u), wake %u\n", now_ms, clock_ms, wake);
+        }
+        if (now_ms - wake > max_late_ms)
+        {
+            max_late_ms = now_ms - wake;
+        }
+    }
+    res.events = host_irqs() / res.calls;
+
+    report(&res);
+    if (max_late_ms)
+    {
+        printf("timemeas_sleep_until: up to %u ms late\n", max_late_ms);
+    }
+}
+
+// Button level at time t [ms] of a 400ms press/release cycle,
+// bouncing for 5ms after each edge
+static uint8_t button_script(uint32_t t)
+{
+    t %= 400;
+    if (t < 100)
+    {
+        return 0;
+    }
+    if (t < 105 || (t >= 300 && t < 305))
+    {
+        return t & 1;
+    }
+    return t < 300;
+}
+
+// Load: two bouncing buttons, like the choreo example
+static void bench_debounce_update(uint32_t passes_per_ms, uint32_t duration_ms)
+{
+    result res = {"debounce_update", 0, 0, 0, "state changes"};
+    debouncer deb_a;
+    debouncer deb_b;
+
+    setup();
+    debounce_init(&deb_a);
+    debounce_init(&deb_b);
+
+    for (uint32_t ms = 0; ms < duration_ms; ms++)
+    {
+        uint8_t a = button_script(ms);
+        uint8_t b = button_script(ms + 200);
+
+        uint64_t t0 = ns_now();
+        for (uint32_t i = 0; i < passes_per_ms; i++)
+        {
+            debounce_update(a, &deb_a);
+            res.events += deb_a.state_changed;
+            debounce_update(b, &deb_b);
+            res.events += deb_b.state_changed;
+        }
+        res.ns += ns_now() - t0;
+        res.calls += 2 * passes_per_ms;
+        host_advance_ms(1);
+    }
+
+    report(&res);
+}
+
+// Load: same two buttons, debounced at once every DEBOUNCE_PINS_INTERVAL ms.
+// Calls are main loop passes, checking the sample time
+static void bench_debounce_pins_update(uint32_t passes_per_ms, uint32_t duration_ms)
+{
+    result res = {"debounce_pins_update", 0, 0, 0, "state changes"};
+    debouncer_pins deb;
+    uint32_t last_sample_time = 0;
+
+    setup();
+    debounce_pins_init(&deb);
+
+    for (uint32_t ms = 0; ms < duration_ms; ms++)
+    {
+        uint8_t sample = button_script(ms) | (button_script(ms + 200) << 1);
+
+        uint64_t t0 = ns_now();
+        for (uint32_t i = 0; i < passes_per_ms; i++)
+        {
+            if (timemeas_now() - last_sample_time < DEBOUNCE_PINS_INTERVAL)
+            {
+                continue;
+            }
+            last_sample_time = timemeas_now();
+            debounce_pins_update(sample, &deb);
+            res.events += __builtin_popcount(deb.pressed | deb.released);
+        }
+        res.ns += ns_now() - t0;
+        res.calls += passes_per_ms;
+        host_advance_ms(1);
+    }
+
+    report(&res);
+}
+
+// Load: one bouncing button (PB0, to GND), while the main loop is blocked
+// for block_ms per pass (e.g. sending frames, delays). Measures the error of
+// the time the main loop gets for each debounced edge: the time of the pass
+// when debouncing in the main loop, the event time with DEBOUNCE_ISR_PINS.
+static void bench_debounce_latency(uint32_t block_ms, uint32_t duration_ms)
+{
+#ifdef DEBOUNCE_ISR_PINS
+    result res = {"debounce latency (isr)", 0, 0, 0, "ms max. latency"};
+#else
+    result res = {"debounce latency (poll)", 0, 0, 0, "ms max. latency"};
+    debouncer_pins deb;
+    debounce_pins_init(&deb);
+#endif
+    uint32_t edges = 0;
+
+    setup();
+    host_set_pins(1 << PB0); // released
+#ifdef DEBOUNCE_ISR_PINS
+    // The ISR debounced PB0 during the other benchmarks as well
+    debounce_isr_reset(0);
+#endif
+    const uint32_t start_ms = timemeas_now();
+    uint32_t edge_time = start_ms;
+
+    for (uint32_t ms = 0; ms < duration_ms;)
+    {
+        // Blocked main loop, the button changes meanwhile
+        for (uint32_t i = 0; i < block_ms; i++, ms++)
+        {
+            if (ms % 400 == 100 || ms % 400 == 300)
+            {
+                edge_time = start_ms + ms;
+            }
+            host_set_pins(button_script(ms) ? 0 : (1 << PB0));
+            host_advance_ms(1);
+        }
+
+        // Main loop pass
+        uint32_t times[4];
+        uint8_t num_times = 0;
+
+        uint64_t t0 = ns_now();
+#ifdef DEBOUNCE_ISR_PINS
+        debounce_event ev;
+        while (debounce_isr_pop(&ev) && num_times < 4)
+        {
+            times[num_times++] = ev.time;
+        }
+#else
+        debounce_pins_update(~PINB & (1 << PB0), &deb);
+        if (deb.pressed | deb.released)
+        {
+            times[num_times++] = timemeas_now();
+        }
+#endif
+        res.ns += ns_now() - t0;
+        res.calls++;
+
+        for (uint8_t i = 0; i < num_times; i++)
+        {
+            edges++;
+            if (times[i] - edge_time > res.events)
+            {
+                res.events = times[i] - edge_time;
+            }
+        }
+    }
+
+    report(&res);
+    if (edges != duration_ms / 200)
+    {
+        printf("debounce latency: %u edges detected, %u expected\n", edges, duration_ms / 200);
+    }
+}
+
+// Load: wire touches (PB0 to GND) every ~50ms, alternating brief (2ms) and
+// long (30ms) ones, while the main
+// loop is blocked for block_ms per pass, like hot_wire sending LED data and
+// stopping choreos. Polls PINB once per pass, or takes the hits latched by
+// pinlatch. Reports the missed touches, and the max. error of the hit time
+// the main loop gets.
+static void bench_wire_hit(uint8_t latched, uint32_t block_ms, uint32_t duration_ms)
+{
+    result res = {latched ? "wire hit (latch)" : "wire hit (poll)", 0, 0, 0, "touches missed"};
+    uint32_t touches = 0;
+    uint32_t detected = 0;
+    uint32_t max_latency = 0;
+
+    setup();
+    pinlatch_init();
+    host_set_pins(1 << PB0); // not touched
+    if (latched)
+    {
+        pinlatch_arm(1 << PB0);
+    }
+
+    const uint32_t start_ms = timemeas_now();
+    uint32_t touch_time = 0;
+    uint32_t touch_len = 0;
+    uint8_t touch_seen = 0;
+    uint32_t next_touch = 10;
+
+    for (uint32_t ms = 0; ms < duration_ms;)
+    {
+        // Blocked main loop, the wire is touched meanwhile
+        for (uint32_t i = 0; i < block_ms; i++, ms++)
+        {
+            if (ms == next_touch)
+            {
+                touches++;
+                touch_time = start_ms + ms;
+                touch_len = (touches & 1) ? 2 : 30;
+                touch_seen = 0;
+                next_touch += 50 + (touches * 7) % 13;
+            }
+            host_set_pins((start_ms + ms - touch_time < touch_len) ? 0 : (1 << PB0));
+            host_advance_ms(1);
+        }
+
+        // Main loop pass
+        uint32_t hit_time;
+        uint8_t hit;
+
+        uint64_t t0 = ns_now();
+        if (latched)
+        {
+            hit = pinlatch_take(PB0, &hit_time);
+        }
+        else
+        {
+            hit = (PINB & (1 << PINB0)) == 0;
+            hit_time = timemeas_now();
+        }
+        res.ns += ns_now() - t0;
+        res.calls++;
+
+        // A long touch may be seen by several passes, count it once
+        if (hit && !touch_seen)
+        {
+            touch_seen = 1;
+            detected++;
+            if (hit_time - touch_time > max_latency)
+            {
+                max_latency = hit_time - touch_time;
+            }
+        }
+    }
+    pinlatch_disarm(1 << PB0);
+
+    res.events = touches - detected;
+    report(&res);
+    printf("%-62s%10u ms max. latency\n", res.name, max_latency);
+}
+
+// Load: converting an 8 color palette at every brightness, like moodlight
+// at startup. Checks gamma_scale() against a multiplication for all inputs
+static void bench_gamma_palette(uint32_t rounds)
+{
+    static const uint8_t palette[8][3] = {
+        {255, 0, 0}, {255, 255, 0}, {168, 255, 0}, {0, 255, 0},
+        {0, 158, 158}, {137, 0, 205}, {88, 141, 198}, {158, 0, 158}};
+    result res = {"gamma_palette", 0, 0, 0, "scale errors"};
+    uint8_t out[8][3];
+    volatile uint8_t sink = 0;
+
+    for (uint16_t v = 0; v < 256; v++)
+    {
+        for (uint16_t b = 0; b < 256; b++)
+        {
+            if (gamma_scale(v, b) != ((v * b) >> 8))
+            {
+                res.events++;
+                check_errors++;
+            }
+        }
+    }
+
+    for (uint32_t r = 0; r < rounds; r++)
+    {
+        uint64_t t0 = ns_now();
+        for (uint16_t b = 0; b < 256; b++)
+        {
+            gamma_palette(palette, out, 8, b);
+            sink = out[7][2];
+        }
+        res.ns += ns_now() - t0;
+        res.calls += 256;
+    }
+    (void)sink;
+
+    report(&res);
+}
+
+static uint32_t choreo_func_calls = 0;
+
+// Stands in for the light choreos of hot_wire: one PORTB write per step
+static uint8_t choreo_func_bench(uint8_t step_old, uint32_t time, const void *data)
+{
+    const uint8_t shift = *(const uint8_t *)data;
+
+    choreo_func_calls++;
+
+    if (step_old == CHOREO_RESET)
+    {
+        PORTB = 0;
+        return CHOREO_IDLE;
+    }
+
+    uint8_t step = (uint8_t)(time >> shift);
+    choreo_wake_at(((time >> shift) + 1) << shift);
+    if (step == step_old)
+    {
+        return step;
+    }
+
+    if (step >= 16)
+    {
+        return CHOREO_IDLE;
+    }
+
+    PORTB ^= (1 << PB1);
+    return step;
+}
+
+// Load: six looping choreos with step times of 32..1024ms, like hot_wire
+static void bench_choreo_tick(uint32_t passes_per_ms, uint32_t duration_ms)
+{
+    static const uint8_t shifts[] = {5, 6, 7, 8, 9, 10};
+    const uint8_t num_choreos = sizeof(shifts) / sizeof(shifts[0]);
+    result res = {"choreo_tick", 0, 0, 0, "choreo func calls"};
+    choreo choreos[sizeof(shifts) / sizeof(shifts[0])];
+
+    setup();
+    for (uint8_t c = 0; c < num_choreos; c++)
+    {
+        choreo_init(&choreos[c], 1, &shifts[c], choreo_func_bench);
+        choreo_start(&choreos[c]);
+    }
+
+    choreo_func_calls = 0;
+    for (uint32_t ms = 0; ms < duration_ms; ms++)
+    {
+        uint64_t t0 = ns_now();
+        for (uint32_t i = 0; i < passes_per_ms; i++)
+        {
+            for (uint8_t c = 0; c < num_choreos; c++)
+            {
+                if (choreos[c].step != CHOREO_IDLE)
+                {
+                    choreo_tick(&choreos[c]);
+                    res.calls++;
+                }
+            }
+        }
+        res.ns += ns_now() - t0;
+        host_advance_ms(1);
+    }
+    res.events = choreo_func_calls;
+
+    report(&res);
+}
+
+// Load: same as bench_choreo_tick(), ticked by a deadline scheduler
+static void bench_choreo_sched_tick(uint32_t passes_per_ms, uint32_t duration_ms)
+{
+    static const uint8_t shifts[] = {5, 6, 7, 8, 9, 10};
+    const uint8_t num_choreos = sizeof(shifts) / sizeof(shifts[0]);
+    result res = {"choreo_sched_tick", 0, 0, 0, "choreo func calls"};
+    choreo choreos[sizeof(shifts) / sizeof(shifts[0])];
+    choreo_sched sched;
+
+    setup();
+    choreo_sched_init(&sched);
+    for (uint8_t c = 0; c < num_choreos; c++)
+    {
+        choreo_init(&choreos[c], 1, &shifts[c], choreo_func_bench);
+        if (!choreo_sched_start(&sched, &choreos[c]))
+        {
+            printf("choreo_sched_tick: scheduler full\n");
+            check_errors++;
+        }
+    }
+
+    choreo_func_calls = 0;
+    for (uint32_t ms = 0; ms < duration_ms; ms++)
+    {
+        uint64_t t0 = ns_now();
+        for (uint32_t i = 0; i < passes_per_ms; i++)
+        {
+            choreo_sched_tick(&sched);
+        }
+        res.ns += ns_now() - t0;
+        res.calls += passes_per_ms;
+        host_advance_ms(1);
+    }
+    res.events = choreo_func_calls;
+
+    report(&res);
+}
+
+// Load: same as bench_choreo_tick(), ticked as a choreo group
+static void bench_choreo_group_tick(uint32_t passes_per_ms, uint32_t duration_ms)
+{
+    static const uint8_t shifts[] = {5, 6, 7, 8, 9, 10};
+    const uint8_t num_choreos = sizeof(shifts) / sizeof(shifts[0]);
+    result res = {"choreo_group_tick", 0, 0, 0, "choreo func calls"};
+    choreo choreos[sizeof(shifts) / sizeof(shifts[0])];
+    choreo_group group;
+
+    setup();
+    choreo_group_init(&group);
+    for (uint8_t c = 0; c < num_choreos; c++)
+    {
+        choreo_init(&choreos[c], 1, &shifts[c], choreo_func_bench);
+        if (!choreo_group_add(&group, &choreos[c]) || !choreo_group_start(&group, &choreos[c]))
+        {
+            printf("choreo_group_tick: group full\n");
+            check_errors++;
+        }
+    }
+
+    choreo_func_calls = 0;
+    for (uint32_t ms = 0; ms < duration_ms; ms++)
+    {
+        uint64_t t0 = ns_now();
+        for (uint32_t i = 0; i < passes_per_ms; i++)
+        {
+            choreo_group_tick(&group);
+        }
+        res.ns += ns_now() - t0;
+        res.calls += passes_per_ms;
+        host_advance_ms(1);
+    }
+    res.events = choreo_func_calls;
+
+    report(&res);
+}
+
+// Check: a full scheduler or group refuses more choreos, and does not leave
+// them running untracked
+static void bench_choreo_full(void)
+{
+    static const uint8_t shift = 5;
+    result res = {"choreo_full", 0, 0, 0, "capacity errors"};
+    choreo choreos[CHOREO_SCHED_SIZE + 1];
+    choreo_sched sched;
+    choreo_group group;
+
+    setup();
+    uint64_t t0 = ns_now();
+
+    choreo_sched_init(&sched);
+    for (uint8_t c = 0; c <= CHOREO_SCHED_SIZE; c++)
+    {
+        choreo_init(&choreos[c], 1, &shift, choreo_func_bench);
+        uint8_t started = choreo_sched_start(&sched, &choreos[c]);
+        res.calls++;
+        if (started != (c < CHOREO_SCHED_SIZE) || (!started && choreos[c].step != CHOREO_IDLE))
+        {
+            printf("choreo_full: sched start %u returned %u, step %u\n", c, started, choreos[c].step);
+            res.events++;
+        }
+    }
+
+    choreo_group_init(&group);
+    for (uint8_t c = 0; c <= CHOREO_GROUP_SIZE; c++)
+    {
+        choreo_init(&choreos[c], 1, &shift, choreo_func_bench);
+        uint8_t added = choreo_group_add(&group, &choreos[c]);
+        uint8_t started = choreo_group_start(&group, &choreos[c]);
+        res.calls += 2;
+        if (added != (c < CHOREO_GROUP_SIZE) || started != added || (!started && choreos[c].step != CHOREO_IDLE))
+        {
+            printf("choreo_full: group member %u added %u, started %u\n", c, added, started);
+            res.events++;
+        }
+    }
+
+    res.ns = ns_now() - t0;
+    check_errors += res.events;
+    report(&res);
+}
+
+// Keyframe shows played by bench_choreo_kf_play(), actions are the arg
+#define KF_ACTION_SET 0
+#define KF_ACTION_OFF 1
+
+static const choreo_keyframe kf_show[] FLASH = {
+    CHOREO_KF_ON_STOP(KF_ACTION_OFF, 0),
+    {0, KF_ACTION_SET, 1},
+    {100, KF_ACTION_SET, 2},
+    {250, KF_ACTION_SET, 3},
+    {251, KF_ACTION_SET, 4},
+    {400, CHOREO_KF_END, 0},
+};
+
+// Same, with the first keyframe after the start
+static const choreo_keyframe kf_show_late[] FLASH = {
+    CHOREO_KF_ON_STOP(KF_ACTION_OFF, 0),
+    {50, KF_ACTION_SET, 1},
+    {100, KF_ACTION_SET, 2},
+    {250, KF_ACTION_SET, 3},
+    {251, KF_ACTION_SET, 4},
+    {400, CHOREO_KF_END, 0},
+};
+
+// Expected action times [ms] since the start, for arg 1..4
+static const uint16_t kf_show_expected[] = {0, 100, 250, 251};
+static const uint16_t kf_show_late_expected[] = {50, 100, 250, 251};
+
+static const uint16_t *kf_expected = kf_show_expected;
+static uint32_t kf_start = 0;
+static uint8_t kf_last_arg = 0;
+static uint32_t kf_errors = 0;
+
+static void kf_action(uint8_t action, uint8_t arg)
+{
+    uint32_t time = timemeas_now() - kf_start;
+
+    if (action == KF_ACTION_OFF)
+    {
+        kf_last_arg = 0;
+        return;
+    }
+
+    // In order, on time
+    if (arg != kf_last_arg + 1 || time != kf_expected[arg - 1])
+    {
+        printf("choreo_kf_play: action %u at %u ms, expected %u at %u ms\n",
+               arg, time, kf_last_arg + 1, kf_expected[kf_last_arg]);
+        kf_errors++;
+    }
+    kf_last_arg = arg;
+}
+
+static uint8_t choreo_func_kf(uint8_t step_old, uint32_t time, const void *data)
+{
+    choreo_func_calls++;
+    return choreo_kf_play(step_old, time, (const choreo_keyframe *)data, kf_action);
+}
+
+// Load: a keyframe show (choreo_keyframes.h), ticked every 1ms, played to
+// the end and stopped halfway. Checks the action times (expected), the IDLE
+// state after the end row and the stop action
+static void bench_choreo_kf_play(const char *name, const choreo_keyframe *show, const uint16_t *expected, uint32_t rounds)
+{
+    result res = {name, 0, 0, 0, "keyframe errors"};
+    choreo cho;
+
+    setup();
+    choreo_init(&cho, 0, show, choreo_func_kf);
+    kf_expected = expected;
+    kf_errors = 0;
+
+    for (uint32_t r = 0; r < rounds; r++)
+    {
+        // Played to the end: all actions, then IDLE
+        kf_start = timemeas_now();
+        kf_last_arg = 0;
+        choreo_start(&cho);
+        // Still running, until the first keyframe. choreo_tick() would
+        // restart an IDLE choreo, choreo_sched and choreo_group drop it
+        if (cho.step == CHOREO_IDLE)
+        {
+            printf("choreo_kf_play: ended at the start\n");
+            kf_errors++;
+        }
+        for (uint32_t ms = 0; ms <= 400; ms++)
+        {
+            uint64_t t0 = ns_now();
+            choreo_tick(&cho);
+            res.ns += ns_now() - t0;
+            res.calls++;
+            host_advance_ms(1);
+        }
+        if (kf_last_arg != 4 || cho.step != CHOREO_IDLE)
+        {
+            printf("choreo_kf_play: ended after action %u, step %u\n", kf_last_arg, cho.step);
+            kf_errors++;
+        }
+
+        // Stopped halfway: the stop action (row 0) is applied
+        kf_start = timemeas_now();
+        kf_last_arg = 0;
+        choreo_start(&cho);
+        for (uint32_t ms = 0; ms < 150; ms++)
+        {
+            choreo_tick(&cho);
+            host_advance_ms(1);
+        }
+        choreo_stop(&cho);
+        if (kf_last_arg != 0 || cho.step != CHOREO_IDLE)
+        {
+            printf("choreo_kf_play: stop left action %u, step %u\n", kf_last_arg, cho.step);
+            kf_errors++;
+        }
+    }
+
+    res.events = kf_errors;
+    check_errors += kf_errors;
+    report(&res);
+}
+
+// Static choreos (choreo_static.h), with 16 bit times like the examples.
+// From here on, choreo_wake_at() is redirected to the static choreos.
+#define CHOREO_TIME16
+#include "../src/choreo_static.h"
+
+static const uint8_t static_shifts[] = {5, 6, 7, 8, 9, 10};
+
+// Same as choreo_func_bench(), for the static choreos
+static uint8_t choreo_func_bench_static(uint8_t step_old, uint32_t time, const void *data)
+{
+    const uint8_t shift = *(const uint8_t *)data;
+
+    choreo_func_calls++;
+
+    if (step_old == CHOREO_RESET)
+    {
+        PORTB = 0;
+        return CHOREO_IDLE;
+    }
+
+    uint8_t step = (uint8_t)(time >> shift);
+    choreo_wake_at(((time >> shift) + 1) << shift);
+    if (step == step_old)
+    {
+        return step;
+    }
+
+    if (step >= 16)
+    {
+        return CHOREO_IDLE;
+    }
+
+    PORTB ^= (1 << PB1);
+    return step;
+}
+
+#define CHOREO_LIST(X)                                         \
+    X(bench0, choreo_func_bench_static, 1, &static_shifts[0]) \
+    X(bench1, choreo_func_bench_static, 1, &static_shifts[1]) \
+    X(bench2, choreo_func_bench_static, 1, &static_shifts[2]) \
+    X(bench3, choreo_func_bench_static, 1, &static_shifts[3]) \
+    X(bench4, choreo_func_bench_static, 1, &static_shifts[4]) \
+    X(bench5, choreo_func_bench_static, 1, &static_shifts[5])
+#include "../src/choreo_static.h"
+
+// Load: same as bench_choreo_tick(), with static choreos
+static void bench_choreo_static_tick(uint32_t passes_per_ms, uint32_t duration_ms)
+{
+    result res = {"choreo_static_tick", 0, 0, 0, "choreo func calls"};
+
+    setup();
+    for (uint8_t id = 0; id < CHOREO_STATIC_COUNT; id++)
+    {
+        choreo_static_start(id);
+    }
+
+    choreo_func_calls = 0;
+    for (uint32_t ms = 0; ms < duration_ms; ms++)
+    {
+        uint64_t t0 = ns_now();
+        for (uint32_t i = 0; i < passes_per_ms; i++)
+        {
+            choreo_static_tick();
+        }
+        res.ns += ns_now() - t0;
+        res.calls += passes_per_ms;
+        host_advance_ms(1);
+    }
+    res.events = choreo_func_calls;
+
+    report(&res);
+}
+
+int main(void)
+{
+    bench_timemeas_now(1000, 10000);
+    bench_timemeas_now_us(10000);
+    bench_timemeas_sleep_until(250, 10000);
+    bench_debounce_update(500, 10000);
+    bench_debounce_pins_update(500, 10000);
+    bench_debounce_latency(20, 10000);
+    bench_wire_hit(0, 15, 10000);
+    bench_wire_hit(1, 15, 10000);
+    bench_gamma_palette(100);
+    bench_choreo_tick(200, 10000);
+    bench_choreo_sched_tick(200, 10000);
+    bench_choreo_group_tick(200, 10000);
+    bench_choreo_static_tick(200, 10000);
+    bench_choreo_full();
+    bench_choreo_kf_play("choreo_kf_play", kf_show, kf_show_expected, 100);
+    bench_choreo_kf_play("choreo_kf_play (late start)", kf_show_late, kf_show_late_expected, 100);
+    return check_errors ? 1 : 0;
+}
@@ -0,0 +1,57 @@
+/*
+Copyright (c) 2026 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+#include <avr/io.h>
+
+// Host stand-in for <avr/interrupt.h>.
+// An ISR becomes an ordinary function. host/shim.c provides weak empty
+// defaults for every vector and calls them when the virtual hardware
+// raises the interrupt and SREG_I is set.
+
+#define ISR(vector, ...) void vector(void)
+
+#define INT0_vect host_vect_int0
+#define PCINT0_vect host_vect_pcint0
+#define TIMER1_COMPA_vect host_vect_timer1_compa
+#define TIMER1_OVF_vect host_vect_timer1_ovf
+#define TIMER0_OVF_vect host_vect_timer0_ovf
+#define ADC_vect host_vect_adc
+#define TIMER0_COMPA_vect host_vect_timer0_compa
+#define WDT_vect host_vect_wdt
+
+void host_vect_int0(void);
+void host_vect_pcint0(void);
+void host_vect_timer1_compa(void);
+void host_vect_timer1_ovf(void);
+void host_vect_timer0_ovf(void);
+void host_vect_adc(void);
+void host_vect_timer0_compa(void);
+void host_vect_wdt(void);
+
+void host_sei(void);
+
+#define sei() host_sei()
+#define cli() (SREG &= (uint8_t)~(1 << SREG_I))
+
+#endif
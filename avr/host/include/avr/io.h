@@ -0,0 +1,180 @@
+/*
+Copyright (c) 2026 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+#include <stdint.h>
+
+// Host stand-in for <avr/io.h> (ATtiny85).
+// Every I/O register is a plain global, defined in host/shim.c. Bit names
+// match avr-libc's iotn85.h, so the shared modules compile unchanged.
+
+extern volatile uint8_t PINB, DDRB, PORTB;
+extern volatile uint8_t ACSR, ADMUX, ADCSRA, ADCH, ADCL, ADCSRB, DIDR0;
+extern volatile uint8_t USICR, USISR, USIDR, USIBR;
+extern volatile uint8_t GPIOR0, GPIOR1, GPIOR2;
+extern volatile uint8_t PRR, WDTCR, CLKPR, PLLCSR, OSCCAL;
+extern volatile uint8_t OCR0A, OCR0B, TCCR0A, TCCR0B, TCNT0;
+extern volatile uint8_t OCR1A, OCR1B, OCR1C, TCNT1, TCCR1, GTCCR;
+extern volatile uint8_t MCUSR, MCUCR, TIFR, TIMSK, GIFR, GIMSK, PCMSK;
+extern volatile uint8_t SREG;
+
+// PORTB, DDRB, PINB
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define DDB0 0
+#define DDB1 1
+#define DDB2 2
+#define DDB3 3
+#define DDB4 4
+#define DDB5 5
+#define PINB0 0
+#define PINB1 1
+#define PINB2 2
+#define PINB3 3
+#define PINB4 4
+#define PINB5 5
+
+// ADMUX, ADCSRA, ADCSRB, DIDR0
+#define MUX0 0
+#define MUX1 1
+#define MUX2 2
+#define MUX3 3
+#define REFS2 4
+#define ADLAR 5
+#define REFS0 6
+#define REFS1 7
+#define ADPS0 0
+#define ADPS1 1
+#define ADPS2 2
+#define ADIE 3
+#define ADIF 4
+#define ADATE 5
+#define ADSC 6
+#define ADEN 7
+#define ADTS0 0
+#define ADTS1 1
+#define ADTS2 2
+#define ADC0D 5
+#define ADC2D 4
+#define ADC3D 3
+#define ADC1D 2
+
+// PRR
+#define PRADC 0
+#define PRUSI 1
+#define PRTIM0 2
+#define PRTIM1 3
+
+// WDTCR
+#define WDP0 0
+#define WDP1 1
+#define WDP2 2
+#define WDE 3
+#define WDCE 4
+#define WDP3 5
+#define WDIE 6
+#define WDIF 7
+
+// USICR
+#define USIOIE 6
+#define USISIE 7
+
+// TCCR0A, TCCR0B
+#define WGM00 0
+#define WGM01 1
+#define COM0B0 4
+#define COM0B1 5
+#define COM0A0 6
+#define COM0A1 7
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define WGM02 3
+#define FOC0B 6
+#define FOC0A 7
+
+// TCCR1, GTCCR
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define CS13 3
+#define COM1A0 4
+#define COM1A1 5
+#define PWM1A 6
+#define CTC1 7
+#define PSR0 0
+#define PSR1 1
+#define FOC1A 2
+#define FOC1B 3
+#define COM1B0 4
+#define COM1B1 5
+#define PWM1B 6
+#define TSM 7
+
+// MCUSR, MCUCR
+#define PORF 0
+#define EXTRF 1
+#define BORF 2
+#define WDRF 3
+#define ISC00 0
+#define ISC01 1
+#define SM0 3
+#define SM1 4
+#define SE 5
+#define PUD 6
+#define BODSE 2
+#define BODS 7
+
+// TIFR, TIMSK
+#define TOV0 1
+#define TOV1 2
+#define OCF0B 3
+#define OCF0A 4
+#define OCF1B 5
+#define OCF1A 6
+#define TOIE0 1
+#define TOIE1 2
+#define OCIE0B 3
+#define OCIE0A 4
+#define OCIE1B 5
+#define OCIE1A 6
+
+// GIFR, GIMSK, PCMSK
+#define PCIF 5
+#define INTF0 6
+#define PCIE 5
+#define INT0 6
+#define PCINT0 0
+#define PCINT1 1
+#define PCINT2 2
+#define PCINT3 3
+#define PCINT4 4
+#define PCINT5 5
+
+#define SREG_I 7
+
+#endif
@@ -0,0 +1,43 @@
+/*
+Copyright (c) 2026 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef HOST_AVR_SLEEP_H
+#define HOST_AVR_SLEEP_H
+
+#include <avr/io.h>
+
+// Host stand-in for <avr/sleep.h>.
+// sleep_cpu() hands control to host/shim.c, which decides what wakes the
+// virtual CPU (see host_sleep_cpu()).
+
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_ADC (1 << SM0)
+#define SLEEP_MODE_PWR_DOWN (1 << SM1)
+
+void host_sleep_cpu(void);
+
+#define set_sleep_mode(mode) (MCUCR = (uint8_t)((MCUCR & ~((1 << SM0) | (1 << SM1))) | (mode)))
+#define sleep_enable() (MCUCR |= (1 << SE))
+#define sleep_disable() (MCUCR &= (uint8_t)~(1 << SE))
+#define sleep_cpu() host_sleep_cpu()
+#define sleep_bod_disable() (MCUCR = (uint8_t)((MCUCR & ~(1 << BODSE)) | (1 << BODS)))
+
+#endif
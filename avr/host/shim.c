@@ -0,0 +1,222 @@
+/*
+Copyright (c) 2026 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "shim.h"
+
+volatile uint8_t PINB, DDRB, PORTB;
+volatile uint8_t ACSR, ADMUX, ADCSRA, ADCH, ADCL, ADCSRB, DIDR0;
+volatile uint8_t USICR, USISR, USIDR, USIBR;
+volatile uint8_t GPIOR0, GPIOR1, GPIOR2;
+volatile uint8_t PRR, WDTCR, CLKPR, PLLCSR, OSCCAL;
+volatile uint8_t OCR0A, OCR0B, TCCR0A, TCCR0B, TCNT0;
+volatile uint8_t OCR1A, OCR1B, OCR1C, TCNT1, TCCR1, GTCCR;
+volatile uint8_t MCUSR, MCUCR, TIFR, TIMSK, GIFR, GIMSK, PCMSK;
+volatile uint8_t SREG;
+
+// Default (empty) vectors. A module's ISR() replaces the matching one.
+__attribute__((weak)) void host_vect_int0(void) {}
+__attribute__((weak)) void host_vect_pcint0(void) {}
+__attribute__((weak)) void host_vect_timer1_compa(void) {}
+__attribute__((weak)) void host_vect_timer1_ovf(void) {}
+__attribute__((weak)) void host_vect_timer0_ovf(void) {}
+__attribute__((weak)) void host_vect_adc(void) {}
+__attribute__((weak)) void host_vect_timer0_compa(void) {}
+__attribute__((weak)) void host_vect_wdt(void) {}
+
+static uint64_t cycles = 0;
+static uint32_t timer0_prescale_cycles = 0;
+static uint32_t irq_count = 0;
+
+static uint16_t timer0_prescaler(void)
+{
+    switch (TCCR0B & ((1 << CS02) | (1 << CS01) | (1 << CS00)))
+    {
+    case 1:
+        return 1;
+    case 2:
+        return 8;
+    case 3:
+        return 64;
+    case 4:
+        return 256;
+    case 5:
+        return 1024;
+    default:
+        return 0; // stopped (or external clock, not emulated)
+    }
+}
+
+// Runs pending, enabled interrupts in vector order, like the AVR would
+static void dispatch(void)
+{
+    while (SREG & (1 << SREG_I))
+    {
+        if ((GIFR & (1 << PCIF)) && (GIMSK & (1 << PCIE)))
+        {
+            GIFR &= ~(1 << PCIF);
+            SREG &= ~(1 << SREG_I);
+            host_vect_pcint0();
+        }
+        else if ((TIFR & (1 << OCF0A)) && (TIMSK & (1 << OCIE0A)))
+        {
+            TIFR &= ~(1 << OCF0A);
+            SREG &= ~(1 << SREG_I);
+            host_vect_timer0_compa();
+        }
+        else
+        {
+            return;
+        }
+        SREG |= (1 << SREG_I); // reti
+        irq_count++;
+    }
+}
+
+static void timer0_tick(void)
+{
+    if ((TCCR0A & (1 << WGM01)) && TCNT0 == OCR0A)
+    {
+        // CTC: compare match clears the counter
+        TCNT0 = 0;
+        TIFR |= (1 << OCF0A);
+    }
+    else
+    {
+        TCNT0++;
+    }
+}
+
+void host_reset(void)
+{
+    PINB = DDRB = PORTB = 0;
+    ACSR = ADMUX = ADCSRA = ADCH = ADCL = ADCSRB = DIDR0 = 0;
+    USICR = USISR = USIDR = USIBR = 0;
+    GPIOR0 = GPIOR1 = GPIOR2 = 0;
+    PRR = WDTCR = CLKPR = PLLCSR = OSCCAL = 0;
+    OCR0A = OCR0B = TCCR0A = TCCR0B = TCNT0 = 0;
+    OCR1A = OCR1B = OCR1C = TCNT1 = TCCR1 = GTCCR = 0;
+    MCUSR = MCUCR = TIFR = TIMSK = GIFR = GIMSK = PCMSK = 0;
+    SREG = 0;
+    cycles = 0;
+    timer0_prescale_cycles = 0;
+    irq_count = 0;
+}
+
+void host_advance_cycles(uint32_t n)
+{
+    cycles += n;
+
+    while (n)
+    {
+        if (GTCCR & (1 << PSR0))
+        {
+            // Prescaler reset, the bit clears itself
+            GTCCR &= ~(1 << PSR0);
+            timer0_prescale_cycles = 0;
+        }
+
+        // Re-read per timer tick, an ISR may change the clock
+        uint16_t prescaler = timer0_prescaler();
+        if (prescaler == 0 || (PRR & (1 << PRTIM0)))
+        {
+            return;
+        }
+
+        uint32_t step = prescaler - timer0_prescale_cycles;
+        if (step > n)
+        {
+            timer0_prescale_cycles += n;
+            return;
+        }
+        n -= step;
+        timer0_prescale_cycles = 0;
+        timer0_tick();
+        dispatch();
+    }
+}
+
+void host_advance_ms(uint32_t ms)
+{
+    while (ms--)
+    {
+        host_advance_cycles(F_CPU / 1000UL);
+    }
+}
+
+uint64_t host_cycles(void)
+{
+    return cycles;
+}
+
+uint32_t host_irqs(void)
+{
+    return irq_count;
+}
+
+void host_set_pins(uint8_t pinb)
+{
+    uint8_t changed = PINB ^ pinb;
+    PINB = pinb;
+
+    if (changed & PCMSK)
+    {
+        GIFR |= (1 << PCIF);
+        dispatch();
+    }
+}
+
+void host_sei(void)
+{
+    SREG |= (1 << SREG_I);
+    dispatch();
+}
+
+void host_sleep_cpu(void)
+{
+    if (!(MCUCR & (1 << SE)))
+    {
+        return;
+    }
+
+    // Power-down stops Timer0: nothing emulated here can wake the CPU,
+    // so behave as if a pin change woke it right away.
+    if ((MCUCR & ((1 << SM1) | (1 << SM0))) == SLEEP_MODE_PWR_DOWN)
+    {
+        return;
+    }
+
+    // Idle: run the clock until any interrupt has been served.
+    // Give up after one virtual second, if no wake source is armed.
+    uint32_t irq_count_old = irq_count;
+    for (uint32_t i = 0; i < F_CPU && irq_count == irq_count_old; i++)
+    {
+        host_advance_cycles(1);
+    }
+}
+
+void host_delay_us(double us)
+{
+    host_advance_cycles((uint32_t)(us * (F_CPU / 1000000.0)));
+}
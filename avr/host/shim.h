@@ -0,0 +1,55 @@
+/*
+Copyright (c) 2026 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef SHIM_H
+#define SHIM_H
+
+#include <stdint.h>
+
+// Virtual ATtiny85 for host builds of the shared AVR modules.
+//
+// The registers declared in include/avr/io.h are plain globals. Timer/Counter0
+// is emulated from TCCR0A/TCCR0B/OCR0A, so timemeas.c runs unchanged: its
+// TIMER0_COMPA_vect is called once per virtual millisecond while SREG_I is
+// set. Time only moves when the host code moves it, which makes benchmarks
+// and scripted inputs deterministic.
+
+// Clears all registers and the virtual clock
+void host_reset(void);
+
+// Advances the virtual clock by a number of CPU cycles (at F_CPU),
+// running Timer0 and its interrupt on the way
+void host_advance_cycles(uint32_t cycles);
+
+// Advances the virtual clock by ms milliseconds
+void host_advance_ms(uint32_t ms);
+
+// Returns CPU cycles since host_reset()
+uint64_t host_cycles(void);
+
+// Returns the number of interrupts served since host_reset()
+uint32_t host_irqs(void);
+
+// Sets the external level of the PORTB pins (PINB).
+// Raises PCINT0_vect for changed pins enabled in PCMSK, if PCIE is set.
+void host_set_pins(uint8_t pinb);
+
+#endif
@@ -0,0 +1,236 @@
+#!/bin/bash
+#
+# Runs the AVR examples in simavr (simbench) with the pin stimuli in
+# stimuli/, and compares the metrics with the baselines in baseline/.
+# Cycle metrics, ISR/sleep shares, flash and SRAM that grow by more than
+# TOLERANCE percent fail the run, and so does a missing baseline.
+#
+# Examples driving an LED strip (STRIPS) are also decoded (strip.c): any
+# timing violation fails the run, as does a bit period other than the 12
+# cycles (16 for APA106) of ws2812b.c. The frames are written to
+# build/<example>.ppm, which must match the baseline image, and as text to
+# build/<example>.strip.txt (the first ones are printed).
+#
+# A reset of the firmware (reset.count, e.g. by the watchdog) fails, and the
+# examples in WDT_WAKES must sleep in power-down and be woken up by the WDT
+# interrupt.
+#
+#   ./run_bench.bash [--update] [<example>...]
+#
+# --update records the current metrics and images as new baselines.
+# LED=apa106 builds the examples with APA106=1 and checks the APA106 timing
+# (results named <example>.apa106).
+# TELEMETRY=1 builds the examples with TELEMETRY=1 and decodes their
+# software UART (uart.c): a baud rate off by more than 2%, any framing,
+# timing or CRC error, or no telemetry frame at all fails. The decoded
+# frames are written to build/<example>.telemetry.frames.txt. Metrics are
+# only printed, there are no baselines for these builds.
+# REV=<git_rev> runs the examples of that revision instead (results named
+# <example>@<git_rev>), and only prints the metrics, e.g. to compare the
+# cycles of a change with the current tree.
+
+cd "$(dirname "$0")"
+
+TOLERANCE=${TOLERANCE:-5}        # [%]
+DURATION_MS=${DURATION_MS:-3000} # simulated time per example
+
+# Examples whose stimuli need more simulated time [ms]
+declare -A DURATIONS=([moodlight]=12000)
+
+# Examples that must sleep in power-down, woken up by the WDT interrupt
+# (__vector_12) without a reset
+declare -A WDT_WAKES=([moodlight]=1)
+
+# Measured functions, if present in the firmware (ISRs __vector_* always)
+FUNCS="choreo_tick choreo_tick_at choreo_group_tick choreo_static_tick debounce_update debounce_pins_update
+ws2812b_bang_byte ws2812b_send_frame ws2812b_send_stream ws2812b_send_fb4 ws2812b_send_fb4_ram gamma_palette timemeas_now"
+
+# LED strip data pin (PORTB) per example
+declare -A STRIPS=([hot_wire]=3 [moodlight]=1 [ws2812b]=1)
+
+# Telemetry pin (PORTB) per example, see TELEMETRY=1
+declare -A UARTS=([hot_wire]=1 [moodlight]=4)
+
+LED=${LED:-ws2812b}
+# Cycles per bit of the transmit loop of ws2812b.c (ws2812b_send_bytes()),
+# at F_CPU 8MHz like all strip examples
+case "$LED" in
+ws2812b) suffix="" make_args=() bit_cycles=12 ;;
+apa106) suffix=".apa106" make_args=(APA106=1) bit_cycles=16 ;;
+*)
+  echo "unknown LED type: $LED"
+  exit 2
+  ;;
+esac
+
+update=0
+if [ "$1" == "--update" ]; then
+  update=1
+  shift
+fi
+
+if [ "$TELEMETRY" == "1" ]; then
+  if [ $update -eq 1 ]; then
+    echo "--update can not be combined with TELEMETRY=1"
+    exit 2
+  fi
+  suffix="$suffix.telemetry"
+  make_args+=(TELEMETRY=1)
+fi
+
+src=../src
+if [ -n "$REV" ]; then
+  if [ $update -eq 1 ]; then
+    echo "--update can not be combined with REV"
+    exit 2
+  fi
+  rev_dir=$(mktemp -d)
+  git worktree add --detach "$rev_dir" "$REV" > /dev/null || exit $?
+  trap 'git worktree remove --force "$rev_dir"' EXIT
+  src=$rev_dir/avr/src
+  suffix="$suffix@$REV"
+fi
+
+examples=("$@")
+if [ ${#examples[@]} -eq 0 ]; then
+  for dir in "$src"/*/; do
+    examples+=("$(basename "$dir")")
+  done
+fi
+
+make -s all || exit $?
+mkdir -p build baseline
+
+rc=0
+for example in "${examples[@]}"; do
+  dir=$src/$example
+  name=$example$suffix
+  out=build/$name.txt
+  ppm=build/$name.ppm
+  strip_txt=build/$name.strip.txt
+  frames=build/$name.frames.txt
+  rm -f "$ppm" "$strip_txt" "$frames"
+
+  (cd "$dir" && make clean > /dev/null && make elf SIM_BENCH=1 "${make_args[@]}" > /dev/null) || {
+    echo "$example: build failed"
+    rc=1
+    continue
+  }
+
+  f_cpu=$(sed -n 's/^F_CPU = //p' "$dir/Makefile")
+
+  args=()
+  if [ -f "stimuli/$example.txt" ]; then
+    args+=(-s "stimuli/$example.txt")
+  fi
+  if [ -n "${STRIPS[$example]}" ]; then
+    args+=(-w "${STRIPS[$example]}" "$LED" -o "$ppm" -f "$strip_txt")
+  fi
+  if [ "$TELEMETRY" == "1" ] && [ -n "${UARTS[$example]}" ]; then
+    # SUART_BAUD of suart.h
+    baud=19200
+    [ "$f_cpu" == 8000000 ] && baud=115200
+    args+=(-u "${UARTS[$example]}" "$baud" -t "$frames")
+  fi
+  while read -r addr type sym; do
+    case "$type" in T | t) ;; *) continue ;; esac
+    case " $(echo $FUNCS) " in *" $sym "*) args+=("$sym=$addr") ;; esac
+    case "$sym" in __vector_[0-9]*) args+=("$sym=$addr") ;; esac
+  done < <(avr-nm "$dir/main.elf")
+
+  {
+    ./build/simbench "$dir/main.elf" "$f_cpu" "${DURATIONS[$example]:-$DURATION_MS}" "${args[@]}" &&
+      avr-size -A "$dir/main.elf" | awk '
+        /^\.text/ { text = $2 }
+        /^\.data/ { data = $2 }
+        /^\.bss/  { bss = $2 }
+        END { print "flash", text + data; print "sram", data + bss }'
+  } > "$out" || {
+    echo "$example: simulation failed"
+    rc=1
+    continue
+  }
+
+  # Do not leave the SIM_BENCH build behind
+  (cd "$dir" && make clean > /dev/null)
+
+  # Any timing violation on the LED strip or UART fails, with or without
+  # baseline, and so does a bit period within a byte other than bit_cycles,
+  # a baud rate off by more than 2%, no telemetry frame, a reset, or (for
+  # WDT_WAKES) no WDT wake-up from power-down.
+  # No baseline is recorded then
+  awk -v name="$name" -v bit_cycles="$bit_cycles" -v wdt="${WDT_WAKES[$example]:-0}" '
+    /^reset\.count / && $2 > 0 { printf "%s: FAIL: %s %s\n", name, $1, $2; failed = 1 }
+    /^isr\.__vector_12\.calls / { wdt_calls = $2 }
+    /^sleep\.pwr_down\.permille / { pwr_down = $2 }
+    /^(strip|uart)\.violations\./ && $2 > 0 { printf "%s: FAIL: %s %s\n", name, $1, $2; failed = 1 }
+    /^uart\.baud\.error\.permille / && $2 > 20 { printf "%s: FAIL: %s %s\n", name, $1, $2; failed = 1 }
+    /^uart\.frames / && $2 == 0 { printf "%s: FAIL: no telemetry frame decoded\n", name; failed = 1 }
+    /^strip\.bit\.cycles\./ && $2 != bit_cycles { printf "%s: FAIL: %s %s, expected %s\n", name, $1, $2, bit_cycles; failed = 1 }
+    END {
+      if (wdt && (wdt_calls + 0 == 0 || pwr_down + 0 == 0)) {
+        printf "%s: FAIL: no power-down sleep woken up by the WDT\n", name
+        failed = 1
+      }
+      exit failed
+    }' "$out" || {
+    rc=1
+    continue
+  }
+
+  echo "--- $name"
+
+  if [ -f "$strip_txt" ]; then
+    head -n 3 "$strip_txt" | sed 's/^/  strip: /'
+  fi
+  if [ -f "$frames" ]; then
+    head -n 3 "$frames" | sed 's/^/  telemetry: /'
+  fi
+
+  if [ $update -eq 1 ]; then
+    cp "$out" "baseline/$name.txt"
+    if [ -f "$ppm" ]; then
+      cp "$ppm" "baseline/$name.ppm"
+    fi
+    echo "  baseline updated"
+    continue
+  fi
+
+  if [ -n "$REV" ] || [ "$TELEMETRY" == "1" ]; then
+    sed 's/^/  /' "$out"
+    continue
+  fi
+
+  if [ ! -f "baseline/$name.txt" ]; then
+    sed 's/^/  /' "$out"
+    echo "  FAIL: no baseline, record one with --update"
+    rc=1
+    continue
+  fi
+
+  awk -v tol="$TOLERANCE" '
+    NR == FNR { base[$1] = $2; next }
+    {
+      key = $1; cur = $2; status = ""
+      if (key in base) {
+        b = base[key]
+        delta = (b > 0) ? sprintf("%+.1f%%", 100.0 * (cur - b) / b) : "-"
+        # Counts (calls, passes) depend on the stimuli, only costs are checked
+        if (key ~ /(cycles\.(mean|max)|share\.permille|^flash|^sram)$/ && cur > b * (1 + tol / 100.0) && cur - b > 1) {
+          status = "FAIL"
+          failed = 1
+        }
+        printf "  %-40s %10s %10s %8s %s\n", key, b, cur, delta, status
+      } else {
+        printf "  %-40s %10s %10s %8s %s\n", key, "-", cur, "new", ""
+      }
+    }
+    END { exit failed }' "baseline/$name.txt" "$out" || rc=1
+
+  if [ -f "baseline/$name.ppm" ] && ! cmp -s "baseline/$name.ppm" "$ppm"; then
+    echo "  FAIL: strip frames differ from baseline/$name.ppm (see $ppm)"
+    rc=1
+  fi
+done
+
+exit $rc
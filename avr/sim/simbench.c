@@ -0,0 +1,433 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+#include <simavr/avr_ioport.h>
+#include "strip.h"
+#include "uart.h"
+
+// Cycle benchmark of an AVR example firmware, run in simavr.
+//
+//   simbench <elf> <f_cpu> <ms> [-s <stimuli>] [-w <pin> <led type> [-o <ppm>] [-f <txt>]]
+//            [-u <pin> <baud> [-t <txt>]] [<name>=<addr>...]
+//
+// Runs the firmware for <ms> milliseconds of simulated time, applying pin
+// stimuli (see stimuli/*.txt), and prints metrics as "key value" lines:
+//   loop.*       main loop passes (SIM_LOOP_MARK(), see src/simbench.h)
+//   func.<name>  calls and cycles of the function at byte address <addr>
+//   isr.*        cycles spent in functions named __vector_*
+//   sleep.*      cycles spent in sleep mode, and per sleep mode (MCUCR SM
+//                bits: idle, adc, pwr_down), to compare the energy of
+//                firmwares (see zzz.h)
+//   reset.count  restarts at address 0 after the start: a watchdog reset
+//                (e.g. a WDT left in reset mode after a sleep), or a jump
+//                there (unhandled interrupt)
+//   strip.*      LED strip on PORTB <pin> (-w, "ws2812b" or "apa106"): frames,
+//                bytes, timing and violations, see strip.c. -o writes the
+//                frames to an image, one row per frame, -f as text
+//   uart.*       software UART on PORTB <pin> (-u, e.g. telemetry): bytes,
+//                measured baud rate, telemetry frames and violations, see
+//                uart.c. -t writes the telemetry frames as text
+// Function cycles are inclusive (callees and interrupts during the call).
+// run_bench.bash passes the addresses, taken from avr-nm.
+
+#define MAX_FUNCS 32
+#define MCUCR_ADDR 0x55 // data address of MCUCR (ATtiny85)
+#define MAX_FRAMES 32
+#define MAX_STIMULI 256
+
+typedef struct
+{
+    const char *name;
+    uint32_t addr; // byte address
+    uint8_t isr;
+    uint64_t calls;
+    uint64_t cycles;
+    uint64_t max;
+} func;
+
+typedef struct
+{
+    uint8_t func_idx;
+    uint16_t sp; // stack pointer right after the call
+    uint64_t start;
+} frame;
+
+typedef struct
+{
+    uint32_t ms;
+    uint8_t pin;
+    uint8_t level;
+} stimulus;
+
+static func funcs[MAX_FUNCS];
+static uint8_t num_funcs = 0;
+
+static frame frames[MAX_FRAMES];
+static uint8_t num_frames = 0;
+static uint8_t isr_depth = 0;
+static uint64_t isr_start = 0;
+static uint64_t isr_cycles = 0;
+
+static stimulus stimuli[MAX_STIMULI];
+static uint16_t num_stimuli = 0;
+static uint32_t stimuli_period = 0; // [ms], 0: no repetition
+
+static uint64_t loop_count = 0;
+static uint64_t loop_last = 0;
+static uint64_t loop_cycles = 0;
+static uint64_t loop_max = 0;
+
+// GPIOR0 write: start of a main loop pass
+static void loop_mark(avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param)
+{
+    avr->data[addr] = v;
+
+    if (loop_count)
+    {
+        uint64_t cycles = avr->cycle - loop_last;
+        loop_cycles += cycles;
+        if (cycles > loop_max)
+        {
+            loop_max = cycles;
+        }
+    }
+    loop_count++;
+    loop_last = avr->cycle;
+}
+
+// Reads "<ms> <pin> <level>" lines and an optional "period <ms>" line
+static int read_stimuli(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        perror(path);
+        return -1;
+    }
+
+    char line[128];
+    while (fgets(line, sizeof(line), file))
+    {
+        unsigned ms, pin, level;
+        if (line[0] == '#' || line[0] == '\n')
+        {
+            continue;
+        }
+        if (sscanf(line, "period %u", &ms) == 1)
+        {
+            stimuli_period = ms;
+        }
+        else if (sscanf(line, "%u %u %u", &ms, &pin, &level) == 3 && num_stimuli < MAX_STIMULI)
+        {
+            stimuli[num_stimuli++] = (stimulus){ms, (uint8_t)pin, (uint8_t)(level != 0)};
+        }
+        else
+        {
+            fprintf(stderr, "%s: invalid line: %s", path, line);
+            fclose(file);
+            return -1;
+        }
+    }
+
+    fclose(file);
+    return 0;
+}
+
+static uint16_t sp_get(avr_t *avr)
+{
+    return avr->data[R_SPL] | (avr->data[R_SPH] << 8);
+}
+
+// Closes the frames of functions that returned (stack pointer above the call)
+static void pop_frames(avr_t *avr, uint16_t sp)
+{
+    while (num_frames && sp > frames[num_frames - 1].sp)
+    {
+        frame *fr = &frames[--num_frames];
+        func *fn = &funcs[fr->func_idx];
+        uint64_t cycles = avr->cycle - fr->start;
+
+        fn->calls++;
+        fn->cycles += cycles;
+        if (cycles > fn->max)
+        {
+            fn->max = cycles;
+        }
+
+        if (fn->isr && --isr_depth == 0)
+        {
+            isr_cycles += avr->cycle - isr_start;
+        }
+    }
+}
+
+static void push_frame(avr_t *avr, uint32_t pc, uint16_t sp)
+{
+    for (uint8_t i = 0; i < num_funcs; i++)
+    {
+        if (funcs[i].addr != pc)
+        {
+            continue;
+        }
+        if (num_frames == MAX_FRAMES)
+        {
+            return;
+        }
+        frames[num_frames++] = (frame){i, sp, avr->cycle};
+        if (funcs[i].isr && isr_depth++ == 0)
+        {
+            isr_start = avr->cycle;
+        }
+        return;
+    }
+}
+
+static uint64_t per_call(uint64_t cycles, uint64_t calls)
+{
+    return calls ? (cycles + calls / 2) / calls : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 4)
+    {
+        fprintf(stderr, "usage: %s <elf> <f_cpu> <ms> [-s <stimuli>] [-w <pin> <led type> [-o <ppm>] [-f <txt>]] [-u <pin> <baud> [-t <txt>]] [<name>=<addr>...]\n", argv[0]);
+        return 2;
+    }
+
+    const char *elf_path = argv[1];
+    uint32_t f_cpu = strtoul(argv[2], NULL, 0);
+    uint32_t duration_ms = strtoul(argv[3], NULL, 0);
+    const strip_timing *strip = 0;
+    uint8_t strip_pin = 0;
+    const char *ppm_path = 0;
+    const char *frames_path = 0;
+    uint32_t uart_baud = 0;
+    uint8_t uart_pin = 0;
+    const char *txt_path = 0;
+
+    for (int i = 4; i < argc; i++)
+    {
+        char *eq = strchr(argv[i], '=');
+        if (!strcmp(argv[i], "-s") && i + 1 < argc)
+        {
+            if (read_stimuli(argv[++i]))
+            {
+                return 2;
+            }
+        }
+        else if (!strcmp(argv[i], "-w") && i + 2 < argc)
+        {
+            strip_pin = strtoul(argv[++i], NULL, 0);
+            strip = strip_timing_by_name(argv[++i]);
+            if (!strip || strip_pin > 5)
+            {
+                fprintf(stderr, "invalid strip: PB%u %s\n", strip_pin, argv[i]);
+                return 2;
+            }
+        }
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+        {
+            ppm_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc)
+        {
+            frames_path = argv[++i];
+        }
+        else if (!strcmp(argv[i], "-u") && i + 2 < argc)
+        {
+            uart_pin = strtoul(argv[++i], NULL, 0);
+            uart_baud = strtoul(argv[++i], NULL, 0);
+            if (!uart_baud || uart_pin > 5)
+            {
+                fprintf(stderr, "invalid uart: PB%u %u baud\n", uart_pin, uart_baud);
+                return 2;
+            }
+        }
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+        {
+            txt_path = argv[++i];
+        }
+        else if (eq && num_funcs < MAX_FUNCS)
+        {
+            *eq = 0;
+            funcs[num_funcs].name = argv[i];
+            funcs[num_funcs].addr = strtoul(eq + 1, NULL, 16);
+            funcs[num_funcs].isr = !strncmp(argv[i], "__vector_", 9);
+            num_funcs++;
+        }
+    }
+
+    elf_firmware_t firmware = {0};
+    if (elf_read_firmware(elf_path, &firmware))
+    {
+        fprintf(stderr, "%s: cannot read firmware\n", elf_path);
+        return 2;
+    }
+
+    avr_t *avr = avr_make_mcu_by_name("attiny85");
+    if (!avr)
+    {
+        fprintf(stderr, "simavr: no attiny85 core\n");
+        return 2;
+    }
+    avr_init(avr);
+    avr->frequency = f_cpu;
+    avr->log = LOG_NONE;
+    avr_load_firmware(avr, &firmware);
+
+    avr_register_io_write(avr, 0x11 + 0x20, loop_mark, NULL); // GPIOR0
+
+    avr_irq_t *pins[6];
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        pins[i] = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), i);
+    }
+
+    if (strip)
+    {
+        strip_attach(avr, strip_pin, strip);
+    }
+
+    if (uart_baud)
+    {
+        uart_attach(avr, uart_pin, uart_baud);
+    }
+
+    const uint64_t cycles_per_ms = f_cpu / 1000;
+    const uint64_t end = (uint64_t)duration_ms * cycles_per_ms;
+    uint64_t sleep_cycles = 0;
+    uint64_t sleep_mode_cycles[4] = {0}; // per MCUCR SM1:SM0
+    uint16_t next_stimulus = 0;
+    uint32_t stimuli_offset = 0; // [ms] start of the current repetition
+    uint64_t resets = 0;
+
+    while (avr->cycle < end)
+    {
+        // Apply due stimuli
+        uint32_t ms = avr->cycle / cycles_per_ms;
+        while (num_stimuli && stimuli_offset + stimuli[next_stimulus].ms <= ms)
+        {
+            avr_raise_irq(pins[stimuli[next_stimulus].pin], stimuli[next_stimulus].level);
+            if (++next_stimulus == num_stimuli)
+            {
+                if (!stimuli_period)
+                {
+                    num_stimuli = 0;
+                    break;
+                }
+                next_stimulus = 0;
+                stimuli_offset += stimuli_period;
+            }
+        }
+
+        uint8_t sleeping = (avr->state == cpu_Sleeping);
+        uint8_t sleep_mode = (avr->data[MCUCR_ADDR] >> 3) & 3;
+        uint64_t cycle_before = avr->cycle;
+
+        int state = avr_run(avr);
+        if (state == cpu_Done || state == cpu_Crashed)
+        {
+            fprintf(stderr, "simavr: firmware stopped (state %d) at cycle %llu\n", state, (unsigned long long)avr->cycle);
+            return 1;
+        }
+
+        if (sleeping)
+        {
+            sleep_cycles += avr->cycle - cycle_before;
+            sleep_mode_cycles[sleep_mode] += avr->cycle - cycle_before;
+        }
+
+        // Reset vector, the firmware restarts
+        if (avr->pc == 0 && cycle_before > 0)
+        {
+            resets++;
+        }
+
+        uint16_t sp = sp_get(avr);
+        pop_frames(avr, sp);
+        push_frame(avr, avr->pc, sp);
+    }
+
+    uint64_t total = avr->cycle;
+
+    printf("cycles %llu\n", (unsigned long long)total);
+    printf("loop.count %llu\n", (unsigned long long)loop_count);
+    printf("loop.cycles.mean %llu\n", (unsigned long long)per_call(loop_cycles, loop_count > 1 ? loop_count - 1 : 0));
+    printf("loop.cycles.max %llu\n", (unsigned long long)loop_max);
+    for (uint8_t i = 0; i < num_funcs; i++)
+    {
+        if (funcs[i].isr)
+        {
+            continue;
+        }
+        printf("func.%s.calls %llu\n", funcs[i].name, (unsigned long long)funcs[i].calls);
+        printf("func.%s.cycles.mean %llu\n", funcs[i].name, (unsigned long long)per_call(funcs[i].cycles, funcs[i].calls));
+        printf("func.%s.cycles.max %llu\n", funcs[i].name, (unsigned long long)funcs[i].max);
+    }
+    for (uint8_t i = 0; i < num_funcs; i++)
+    {
+        if (funcs[i].isr)
+        {
+            printf("isr.%s.calls %llu\n", funcs[i].name, (unsigned long long)funcs[i].calls);
+            printf("isr.%s.cycles.mean %llu\n", funcs[i].name, (unsigned long long)per_call(funcs[i].cycles, funcs[i].calls));
+        }
+    }
+    printf("isr.share.permille %llu\n", (unsigned long long)(total ? isr_cycles * 1000 / total : 0));
+    printf("sleep.share.permille %llu\n", (unsigned long long)(total ? sleep_cycles * 1000 / total : 0));
+    printf("sleep.idle.permille %llu\n", (unsigned long long)(total ? sleep_mode_cycles[0] * 1000 / total : 0));
+    printf("sleep.adc.permille %llu\n", (unsigned long long)(total ? sleep_mode_cycles[1] * 1000 / total : 0));
+    printf("sleep.pwr_down.permille %llu\n", (unsigned long long)(total ? sleep_mode_cycles[2] * 1000 / total : 0));
+    printf("reset.count %llu\n", (unsigned long long)resets);
+
+    if (strip)
+    {
+        strip_finish(avr);
+        strip_print(total);
+        if (ppm_path && strip_write_ppm(ppm_path))
+        {
+            return 1;
+        }
+        if (frames_path && strip_write_frames(frames_path))
+        {
+            return 1;
+        }
+    }
+
+    if (uart_baud)
+    {
+        uart_finish(avr);
+        uart_print();
+        if (txt_path && uart_write_frames(txt_path))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
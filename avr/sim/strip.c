@@ -0,0 +1,353 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_io.h>
+#include <simavr/avr_ioport.h>
+#include "strip.h"
+
+/*
+Limits from the datasheets (+-150ns on all HIGH and LOW times). The LOW time
+of a bit is only checked against its minimum: ws2812b.c relies on the LOW
+part being stretchable up to the reset time.
+
+WS2812B: T0H 400ns, T1H 800ns, T0L 850ns, T1L 450ns, reset > 50us
+APA106:  T0H 350ns, T1H 1360ns, T0L 1360ns, T1L 350ns, reset > 50us
+*/
+static const strip_timing timings[] = {
+    {"ws2812b", 250, 550, 650, 950, 300, 50000},
+    {"apa106", 200, 500, 1210, 1510, 200, 50000},
+};
+
+#define MAX_FRAME_BYTES 768 // 256 LEDs
+#define MAX_FRAMES 4096      // kept for the image, later frames are only counted
+
+typedef struct
+{
+    uint64_t start; // [cycles] first rising edge
+    uint16_t len;
+    uint8_t *data;
+} frame;
+
+static const strip_timing *timing = 0;
+static uint32_t f_cpu = 0;
+
+static uint8_t level = 0;
+static uint64_t rise = 0;
+static uint64_t fall = 0;
+static uint8_t fall_seen = 0;
+
+// Frame being received
+static uint8_t buf[MAX_FRAME_BYTES];
+static uint16_t buf_len = 0;
+static uint8_t bits = 0;
+static uint8_t num_bits = 0;
+static uint64_t buf_start = 0;
+
+static frame frames[MAX_FRAMES];
+static uint32_t num_frames = 0;  // kept
+static uint64_t num_latched = 0; // all
+static uint64_t num_bytes = 0;
+static uint64_t frame_cycles = 0; // first rising to last falling edge, all frames
+
+// Extremes [cycles], UINT64_MAX: not seen
+static uint64_t t0h_min = UINT64_MAX, t0h_max = 0;
+static uint64_t t1h_min = UINT64_MAX, t1h_max = 0;
+static uint64_t tl_min = UINT64_MAX, tl_max = 0; // LOW within a frame
+static uint64_t tb_min = UINT64_MAX, tb_max = 0; // bit period within a byte
+
+static uint64_t violations_high = 0;    // HIGH time neither a zero nor a one
+static uint64_t violations_low = 0;     // LOW time too short
+static uint64_t violations_partial = 0; // frame latched within a byte
+static uint64_t violations_dropped = 0; // bytes beyond MAX_FRAME_BYTES
+
+static uint64_t ns_to_cycles(uint32_t ns)
+{
+    return ((uint64_t)ns * f_cpu + 999999999) / 1000000000;
+}
+
+static uint64_t cycles_to_ns(uint64_t cycles)
+{
+    return cycles * 1000000000 / f_cpu;
+}
+
+const strip_timing *strip_timing_by_name(const char *name)
+{
+    for (size_t i = 0; i < sizeof(timings) / sizeof(timings[0]); i++)
+    {
+        if (!strcmp(timings[i].name, name))
+        {
+            return &timings[i];
+        }
+    }
+    return 0;
+}
+
+static void latch(void)
+{
+    if (num_bits)
+    {
+        violations_partial++;
+        num_bits = 0;
+    }
+    if (buf_len == 0)
+    {
+        return;
+    }
+
+    num_latched++;
+    num_bytes += buf_len;
+    frame_cycles += fall - buf_start;
+
+    if (num_frames < MAX_FRAMES)
+    {
+        frames[num_frames].start = buf_start;
+        frames[num_frames].len = buf_len;
+        frames[num_frames].data = malloc(buf_len);
+        memcpy(frames[num_frames].data, buf, buf_len);
+        num_frames++;
+    }
+    buf_len = 0;
+}
+
+static void rising(uint64_t now)
+{
+    if (fall_seen)
+    {
+        uint64_t low = now - fall;
+        if (low >= ns_to_cycles(timing->reset))
+        {
+            latch();
+        }
+        else
+        {
+            if (low < ns_to_cycles(timing->tl_min))
+            {
+                violations_low++;
+            }
+            if (low < tl_min)
+            {
+                tl_min = low;
+            }
+            if (low > tl_max)
+            {
+                tl_max = low;
+            }
+
+            // Bit period, only within a byte: between bytes, the line
+            // stays LOW longer (loading the next byte, interrupts)
+            if (num_bits)
+            {
+                uint64_t period = now - rise;
+                tb_min = (period < tb_min) ? period : tb_min;
+                tb_max = (period > tb_max) ? period : tb_max;
+            }
+        }
+    }
+
+    if (buf_len == 0 && num_bits == 0)
+    {
+        buf_start = now;
+    }
+    rise = now;
+}
+
+static void falling(uint64_t now)
+{
+    uint64_t high = now - rise;
+    uint8_t one;
+
+    if (high >= ns_to_cycles(timing->t0h_min) && high <= ns_to_cycles(timing->t0h_max))
+    {
+        one = 0;
+    }
+    else if (high >= ns_to_cycles(timing->t1h_min) && high <= ns_to_cycles(timing->t1h_max))
+    {
+        one = 1;
+    }
+    else
+    {
+        // Decode it like a strip would, by the mid point
+        violations_high++;
+        one = (cycles_to_ns(high) > (timing->t0h_max + timing->t1h_min) / 2);
+    }
+
+    if (one)
+    {
+        t1h_min = (high < t1h_min) ? high : t1h_min;
+        t1h_max = (high > t1h_max) ? high : t1h_max;
+    }
+    else
+    {
+        t0h_min = (high < t0h_min) ? high : t0h_min;
+        t0h_max = (high > t0h_max) ? high : t0h_max;
+    }
+
+    bits = (bits << 1) | one;
+    if (++num_bits == 8)
+    {
+        if (buf_len < MAX_FRAME_BYTES)
+        {
+            buf[buf_len++] = bits;
+        }
+        else
+        {
+            violations_dropped++;
+        }
+        num_bits = 0;
+    }
+
+    fall = now;
+    fall_seen = 1;
+}
+
+static void pin_changed(avr_irq_t *irq, uint32_t value, void *param)
+{
+    avr_t *avr = (avr_t *)param;
+    uint8_t new_level = (value != 0);
+
+    if (new_level == level)
+    {
+        return;
+    }
+    level = new_level;
+
+    if (level)
+    {
+        rising(avr->cycle);
+    }
+    else
+    {
+        falling(avr->cycle);
+    }
+}
+
+void strip_attach(avr_t *avr, uint8_t pin, const strip_timing *t)
+{
+    timing = t;
+    f_cpu = avr->frequency;
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), pin), pin_changed, avr);
+}
+
+void strip_finish(avr_t *avr)
+{
+    if (!level && fall_seen && avr->cycle - fall >= ns_to_cycles(timing->reset))
+    {
+        latch();
+    }
+}
+
+static void print_ns(const char *key, uint64_t cycles)
+{
+    printf("strip.%s %llu\n", key, (unsigned long long)(cycles == UINT64_MAX ? 0 : cycles_to_ns(cycles)));
+}
+
+void strip_print(uint64_t cycles)
+{
+    uint64_t ms = cycles * 1000 / f_cpu;
+
+    printf("strip.frames %llu\n", (unsigned long long)num_latched);
+    printf("strip.frames.per_s %llu\n", (unsigned long long)(ms ? (num_latched * 1000 + ms / 2) / ms : 0));
+    printf("strip.frame.us.mean %llu\n", (unsigned long long)(num_latched ? cycles_to_ns(frame_cycles / num_latched) / 1000 : 0));
+    printf("strip.leds %u\n", num_frames ? frames[num_frames - 1].len / 3 : 0);
+    printf("strip.bytes %llu\n", (unsigned long long)num_bytes);
+    printf("strip.bytes.per_s %llu\n", (unsigned long long)(ms ? (num_bytes * 1000 + ms / 2) / ms : 0));
+    print_ns("t0h.ns.min", t0h_min);
+    print_ns("t0h.ns.max", t0h_max);
+    print_ns("t1h.ns.min", t1h_min);
+    print_ns("t1h.ns.max", t1h_max);
+    print_ns("tl.ns.min", tl_min);
+    print_ns("tl.ns.max", tl_max);
+    printf("strip.bit.cycles.min %llu\n", (unsigned long long)(tb_min == UINT64_MAX ? 0 : tb_min));
+    printf("strip.bit.cycles.max %llu\n", (unsigned long long)tb_max);
+    printf("strip.violations.high %llu\n", (unsigned long long)violations_high);
+    printf("strip.violations.low %llu\n", (unsigned long long)violations_low);
+    printf("strip.violations.partial %llu\n", (unsigned long long)violations_partial);
+    printf("strip.violations.dropped %llu\n", (unsigned long long)violations_dropped);
+}
+
+int strip_write_ppm(const char *path)
+{
+    uint16_t width = 1;
+    for (uint32_t i = 0; i < num_frames; i++)
+    {
+        if (frames[i].len / 3 > width)
+        {
+            width = frames[i].len / 3;
+        }
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        perror(path);
+        return -1;
+    }
+
+    fprintf(file, "P6\n%u %lu\n255\n", width, (unsigned long)(num_frames ? num_frames : 1));
+    for (uint32_t i = 0; i < (num_frames ? num_frames : 1); i++)
+    {
+        for (uint16_t x = 0; x < width; x++)
+        {
+            // GRB on the wire, RGB in the image. Missing pixels are black
+            uint8_t rgb[3] = {0, 0, 0};
+            if (i < num_frames && (x + 1) * 3 <= frames[i].len)
+            {
+                rgb[0] = frames[i].data[x * 3 + 1];
+                rgb[1] = frames[i].data[x * 3];
+                rgb[2] = frames[i].data[x * 3 + 2];
+            }
+            fwrite(rgb, 1, 3, file);
+        }
+    }
+
+    fclose(file);
+    return 0;
+}
+
+int strip_write_frames(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        perror(path);
+        return -1;
+    }
+
+    // frame <n> at <ms>: <leds> leds, RGB hex per LED (GRB on the wire)
+    for (uint32_t i = 0; i < num_frames; i++)
+    {
+        fprintf(file, "frame %lu at %.3f ms: %u leds:", (unsigned long)i,
+                (double)frames[i].start * 1000.0 / f_cpu, frames[i].len / 3);
+        for (uint16_t x = 0; (x + 1) * 3 <= frames[i].len; x++)
+        {
+            fprintf(file, " %02x%02x%02x", frames[i].data[x * 3 + 1], frames[i].data[x * 3], frames[i].data[x * 3 + 2]);
+        }
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef STRIP_H
+#define STRIP_H
+
+#include <stdint.h>
+#include <simavr/sim_avr.h>
+
+// Virtual WS2812B/APA106 strip on a PORTB pin: decodes the waveform the
+// firmware produces, checks its timing and collects the latched frames.
+
+// Timing limits [ns] of an LED type
+typedef struct
+{
+    const char *name;
+    uint32_t t0h_min, t0h_max; // HIGH time of a zero
+    uint32_t t1h_min, t1h_max; // HIGH time of a one
+    uint32_t tl_min;           // LOW time between two bits
+    uint32_t reset;            // LOW time that latches a frame
+} strip_timing;
+
+// Returns the timing limits of the LED type name ("ws2812b", "apa106"), or 0
+const strip_timing *strip_timing_by_name(const char *name);
+
+// Starts decoding the output of PORTB pin
+void strip_attach(avr_t *avr, uint8_t pin, const strip_timing *timing);
+
+// Ends decoding: latches a pending frame if the line stayed LOW long enough
+void strip_finish(avr_t *avr);
+
+// Prints the metrics as "strip.* value" lines
+void strip_print(uint64_t cycles);
+
+// Writes all frames to a binary PPM image, one row of pixels per frame
+int strip_write_ppm(const char *path);
+
+// Writes all frames as text, one line of RGB hex values per frame
+int strip_write_frames(const char *path);
+
+#endif
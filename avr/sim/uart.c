@@ -0,0 +1,286 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_io.h>
+#include <simavr/avr_ioport.h>
+#include "uart.h"
+
+/*
+Each byte is sampled in the middle of its 10 bits (start, 8 data bits LSB
+first, stop), measured from the falling edge of the start bit, like a real
+receiver. Every edge within a byte is also checked against the nominal bit
+grid: a receiver tolerates about 1/4 bit of drift over a byte. The measured
+baud rate is fitted to all these edges.
+
+A line that stays LOW through the stop bit is a break (e.g. the telemetry
+pin of hot_wire is pulled LOW after each frame), not a framing error.
+*/
+
+#define MAX_BYTES 4096          // kept for the telemetry frames
+#define TELEMETRY_HEADER_LEN 9  // sync, source, seq, counters, hists, bins, interval
+#define MAX_FRAMES 64           // written by uart_write_frames()
+
+static uint32_t f_cpu = 0;
+static uint32_t nominal_baud = 0;
+static double bit_cycles = 0; // nominal
+
+static uint8_t level = 1;
+static uint8_t in_byte = 0;
+static uint64_t start = 0;   // falling edge of the start bit
+static uint8_t num_samples = 0;
+static uint16_t samples = 0; // bit i: level in the middle of bit i
+
+static uint8_t bytes[MAX_BYTES];
+static uint32_t num_bytes = 0;  // kept
+static uint64_t all_bytes = 0;
+static uint64_t breaks = 0;
+
+// Fit of the bit period: edge offsets from the start bit, in bits
+static double fit_cycles = 0;
+static uint64_t fit_bits = 0;
+static double edge_error_max = 0; // [bits]
+
+static uint64_t violations_framing = 0; // stop bit LOW (not a break)
+static uint64_t violations_edge = 0;    // edge off the bit grid by more than 1/4 bit
+static uint64_t violations_crc = 0;     // telemetry frame with a wrong CRC
+
+typedef struct
+{
+    uint32_t offset; // in bytes
+    uint16_t len;
+} frame;
+
+static frame frames[MAX_FRAMES];
+static uint32_t num_frames = 0; // kept
+static uint64_t all_frames = 0;
+
+static uint8_t crc8(const uint8_t *data, uint16_t len)
+{
+    uint8_t crc = 0;
+    for (uint16_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t b = 0; b < 8; b++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Checks the telemetry frame that may end with the latest byte
+static void frame_check(void)
+{
+    static uint32_t frame_start = 0;
+    static uint8_t syncing = 1;
+
+    if (syncing)
+    {
+        if (num_bytes >= 2 && bytes[num_bytes - 2] == 0x55 && bytes[num_bytes - 1] == 0xaa)
+        {
+            frame_start = num_bytes - 2;
+            syncing = 0;
+        }
+        return;
+    }
+
+    uint32_t len = num_bytes - frame_start;
+    if (len < TELEMETRY_HEADER_LEN)
+    {
+        return;
+    }
+
+    const uint8_t *fr = &bytes[frame_start];
+    uint32_t values = fr[4] + (uint32_t)fr[5] * fr[6];
+    uint32_t frame_len = TELEMETRY_HEADER_LEN + values * 2 + 1;
+    if (len < frame_len)
+    {
+        return;
+    }
+
+    if (crc8(fr, frame_len - 1) == fr[frame_len - 1])
+    {
+        if (num_frames < MAX_FRAMES)
+        {
+            frames[num_frames++] = (frame){frame_start, (uint16_t)frame_len};
+        }
+        all_frames++;
+    }
+    else
+    {
+        violations_crc++;
+    }
+    syncing = 1;
+}
+
+static void byte_done(void)
+{
+    uint8_t stop = (samples >> 9) & 1;
+    uint8_t data = (samples >> 1) & 0xff;
+
+    in_byte = 0;
+
+    if (!stop)
+    {
+        if ((samples & 0x3ff) == 0)
+        {
+            breaks++;
+        }
+        else
+        {
+            violations_framing++;
+        }
+        return;
+    }
+
+    all_bytes++;
+    if (num_bytes < MAX_BYTES)
+    {
+        bytes[num_bytes++] = data;
+        frame_check();
+    }
+}
+
+// Takes the samples due before now, with the current level
+static void sample_until(uint64_t now)
+{
+    while (in_byte && start + (num_samples + 0.5) * bit_cycles < now)
+    {
+        samples |= (uint16_t)level << num_samples;
+        if (++num_samples == 10)
+        {
+            byte_done();
+        }
+    }
+}
+
+static void pin_changed(avr_irq_t *irq, uint32_t value, void *param)
+{
+    avr_t *avr = (avr_t *)param;
+    uint8_t new_level = (value != 0);
+
+    if (new_level == level)
+    {
+        return;
+    }
+
+    sample_until(avr->cycle);
+    level = new_level;
+
+    if (in_byte)
+    {
+        // Position on the bit grid of this byte
+        double offset = (avr->cycle - start) / bit_cycles;
+        uint32_t k = (uint32_t)(offset + 0.5);
+        double error = offset - k;
+        if (error < 0)
+        {
+            error = -error;
+        }
+        if (error > edge_error_max)
+        {
+            edge_error_max = error;
+        }
+        if (error > 0.25)
+        {
+            violations_edge++;
+        }
+        if (k > 0)
+        {
+            fit_cycles += avr->cycle - start;
+            fit_bits += k;
+        }
+    }
+    else if (!level)
+    {
+        in_byte = 1;
+        start = avr->cycle;
+        num_samples = 0;
+        samples = 0;
+    }
+}
+
+void uart_attach(avr_t *avr, uint8_t pin, uint32_t baud)
+{
+    f_cpu = avr->frequency;
+    nominal_baud = baud;
+    bit_cycles = (double)f_cpu / baud;
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), pin), pin_changed, avr);
+}
+
+void uart_finish(avr_t *avr)
+{
+    sample_until(avr->cycle);
+}
+
+void uart_print(void)
+{
+    uint32_t baud = fit_bits ? (uint32_t)(f_cpu * (double)fit_bits / fit_cycles + 0.5) : 0;
+    uint32_t error = baud > nominal_baud ? baud - nominal_baud : nominal_baud - baud;
+
+    printf("uart.bytes %llu\n", (unsigned long long)all_bytes);
+    printf("uart.breaks %llu\n", (unsigned long long)breaks);
+    printf("uart.frames %llu\n", (unsigned long long)all_frames);
+    printf("uart.baud %u\n", baud);
+    printf("uart.baud.error.permille %u\n", baud ? (uint32_t)((uint64_t)error * 1000 / nominal_baud) : 0);
+    printf("uart.edge.error.percent.max %u\n", (uint32_t)(edge_error_max * 100 + 0.5));
+    printf("uart.violations.framing %llu\n", (unsigned long long)violations_framing);
+    printf("uart.violations.edge %llu\n", (unsigned long long)violations_edge);
+    printf("uart.violations.crc %llu\n", (unsigned long long)violations_crc);
+}
+
+int uart_write_frames(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        perror(path);
+        return -1;
+    }
+
+    // source seq interval: counters | histogram bins ...
+    for (uint32_t i = 0; i < num_frames; i++)
+    {
+        const uint8_t *fr = &bytes[frames[i].offset];
+        uint8_t counters = fr[4];
+        uint8_t hists = fr[5];
+        uint8_t bins = fr[6];
+        const uint8_t *values = fr + TELEMETRY_HEADER_LEN;
+
+        fprintf(file, "source %u seq %u interval %u: counters", fr[2], fr[3], fr[7] | (fr[8] << 8));
+        for (uint32_t v = 0; v < counters + (uint32_t)hists * bins; v++)
+        {
+            if (v >= counters && (v - counters) % bins == 0)
+            {
+                fprintf(file, " | hist");
+            }
+            fprintf(file, " %u", values[v * 2] | (values[v * 2 + 1] << 8));
+        }
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+    return 0;
+}
@@ -0,0 +1,44 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef UART_H
+#define UART_H
+
+#include <stdint.h>
+#include <simavr/sim_avr.h>
+
+// Virtual UART receiver (8N1) on a PORTB pin: decodes the output of the
+// software UART (suart.c), checks its bit timing and the telemetry frames
+// it carries (telemetry.h).
+
+// Starts decoding the output of PORTB pin at the nominal baud rate
+void uart_attach(avr_t *avr, uint8_t pin, uint32_t baud);
+
+// Ends decoding: completes a pending byte
+void uart_finish(avr_t *avr);
+
+// Prints the metrics as "uart.* value" lines
+void uart_print(void);
+
+// Writes the decoded telemetry frames as text, one per line
+int uart_write_frames(const char *path);
+
+#endif
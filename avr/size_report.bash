@@ -0,0 +1,46 @@
+#!/bin/bash
+#
+# Prints flash and static SRAM usage (.data + .bss) of all AVR examples.
+# If a git revision is given, the examples are also built at that revision
+# and the SRAM saved by the current tree is reported.
+#
+#   ./size_report.bash [<git_rev>]
+
+cd "$(dirname "$0")"
+
+# Prints "<flash> <sram>" of the example in directory $1
+sizes() {
+  (cd "$1" && make clean > /dev/null && make elf > /dev/null) || return $?
+  avr-size -A "$1/main.elf" | awk '
+    /^\.text/ { text = $2 }
+    /^\.data/ { data = $2 }
+    /^\.bss/  { bss = $2 }
+    END { print text + data, data + bss }'
+}
+
+if [ -n "$1" ]; then
+  base_dir=$(mktemp -d)
+  git worktree add --detach "$base_dir" "$1" > /dev/null || exit $?
+  trap 'git worktree remove --force "$base_dir"' EXIT
+  printf "%-14s %8s %8s %12s %12s %10s\n" example flash sram "flash($1)" "sram($1)" "sram saved"
+else
+  printf "%-14s %8s %8s\n" example flash sram
+fi
+
+for dir in src/*/; do
+  example=$(basename "$dir")
+  out=$(sizes "$dir") || exit 1
+  read -r flash sram <<< "$out"
+
+  if [ -n "$1" ]; then
+    if [ -d "$base_dir/avr/$dir" ]; then
+      out=$(sizes "$base_dir/avr/$dir") || exit 1
+      read -r base_flash base_sram <<< "$out"
+      printf "%-14s %8d %8d %12d %12d %10d\n" "$example" "$flash" "$sram" "$base_flash" "$base_sram" $((base_sram - sram))
+    else
+      printf "%-14s %8d %8d %12s %12s %10s\n" "$example" "$flash" "$sram" - - -
+    fi
+  else
+    printf "%-14s %8d %8d\n" "$example" "$flash" "$sram"
+  fi
+done
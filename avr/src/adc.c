@@ -0,0 +1,172 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "adc.h"
+#include "zzz.h"
+
+#if ADC_OVERSAMPLE > 3
+#error ADC_OVERSAMPLE must be 0..3, the sum of the conversions is 16 bit
+#endif
+
+#if (ADC_QUEUE_SIZE & (ADC_QUEUE_SIZE - 1)) != 0
+#error ADC_QUEUE_SIZE must be a power of 2
+#endif
+
+// ADC Prescaler Select for a 125kHz ADC clock (50-200kHz for 10 bit)
+#if F_CPU == 1000000
+#define ADPS_125K ((1 << ADPS1) | (1 << ADPS0)) // divided by 8
+#elif F_CPU == 8000000
+#define ADPS_125K ((1 << ADPS2) | (1 << ADPS1)) // divided by 64
+#else
+#error ADC is only configured for an I/O Clock of 1MHz or 8MHz
+#endif
+
+// Conversions per result
+#define ADC_SUM_COUNT (1 << (2 * ADC_OVERSAMPLE))
+
+// Sum of the conversions so far, ISR only
+static uint16_t sum = 0;
+static uint8_t sum_count = 0;
+
+static volatile uint16_t latest = 0;
+static volatile uint8_t latest_guard = 0;
+static volatile uint8_t latest_valid = 0; // set with the first result
+
+// Single producer (ISR), single consumer (main loop) ring buffer, see debounce.c
+static uint16_t queue[ADC_QUEUE_SIZE];
+static volatile uint8_t head = 0; // next slot to write, ISR only
+static volatile uint8_t tail = 0; // next slot to read, main loop only
+volatile uint8_t adc_dropped = 0;
+
+// Adds the result of the last conversion, publishes a result every
+// ADC_SUM_COUNT conversions. ISR only
+static void adc_collect(void)
+{
+    // ADCL must be read first, it locks the result until ADCH is read
+    uint8_t low = ADCL;
+    sum += low | ((uint16_t)ADCH << 8);
+
+    if (++sum_count < ADC_SUM_COUNT)
+    {
+        return;
+    }
+
+    uint16_t value = sum >> ADC_OVERSAMPLE;
+    sum = 0;
+    sum_count = 0;
+
+    latest_guard = 1;
+    latest = value;
+    latest_valid = 1;
+
+    uint8_t next = (head + 1) & (ADC_QUEUE_SIZE - 1);
+    if (next == tail)
+    {
+        adc_dropped++;
+        return;
+    }
+
+    queue[head] = value;
+
+    // Publish the slot only after it is written
+    __asm__ volatile("" ::: "memory");
+    head = next;
+}
+
+#ifdef ADC_TIMER0
+void adc_isr_tick(void)
+{
+    // The conversion started by this compare match is still running,
+    // the result is the one of the previous
+    if (ADCSRA & (1 << ADIF))
+    {
+        ADCSRA |= (1 << ADIF); // Cleared by writing 1
+        adc_collect();
+    }
+}
+#else
+ISR(ADC_vect)
+{
+    adc_collect();
+}
+#endif
+
+void adc_init(uint8_t admux)
+{
+    adc_stop();
+
+    zzz_power_on(1 << PRADC);
+    ADMUX = admux;
+
+#ifdef ADC_TIMER0
+    // Auto trigger: Timer/Counter0 Compare Match A
+    ADCSRB = (1 << ADTS1) | (1 << ADTS0);
+    ADCSRA = (1 << ADEN) | (1 << ADATE) | (1 << ADIF) | ADPS_125K;
+#else
+    // Auto trigger: free running, started once
+    ADCSRB = 0;
+    ADCSRA = (1 << ADEN) | (1 << ADSC) | (1 << ADATE) | (1 << ADIE) | (1 << ADIF) | ADPS_125K;
+#endif
+}
+
+void adc_stop(void)
+{
+    ADCSRA = (1 << ADIF);
+    sum = 0;
+    sum_count = 0;
+    latest_valid = 0;
+}
+
+uint8_t adc_read(uint16_t *value)
+{
+    if (!latest_valid)
+    {
+        return 0;
+    }
+
+    uint16_t ret;
+    do
+    {
+        latest_guard = 0;
+        ret = latest;
+    } while (latest_guard);
+    *value = ret;
+    return 1;
+}
+
+uint8_t adc_pop(uint16_t *value)
+{
+    uint8_t t = tail;
+    if (t == head)
+    {
+        return 0;
+    }
+
+    *value = queue[t];
+
+    // Release the slot only after it is read
+    __asm__ volatile("" ::: "memory");
+    tail = (t + 1) & (ADC_QUEUE_SIZE - 1);
+    return 1;
+}
@@ -0,0 +1,79 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef ADC_H
+#define ADC_H
+
+#include <stdint.h>
+
+// ADC sampling in the background, with oversampling.
+//
+// Conversions are started by the hardware (auto trigger), the main loop
+// never waits for one. Two ways:
+//  - Default: free running. The ADC starts the next conversion right after
+//    one completes (13 ADC cycles, ~9.6k/s), ADC_vect collects the results.
+//    Each interrupt ends timemeas_sleep_until() (and idle sleep), like any
+//    other interrupt.
+//  - ADC_TIMER0 defined (e.g. in the Makefile CDEFS): every Timer0 compare
+//    match (1ms, see timemeas.h) starts a conversion, and TIMER0_COMPA_vect
+//    collects the result of the previous one. No ADC interrupt, no extra
+//    wake-ups.
+// The results of 4^ADC_OVERSAMPLE conversions are summed and decimated to
+// 10 + ADC_OVERSAMPLE bits. This only adds resolution if there is noise of
+// about 1 LSB, which is usually the case. Each result is stored as the
+// latest (adc_read()) and queued (adc_pop()).
+// The ADC clock is set to 125kHz (F_CPU 1MHz or 8MHz).
+
+// Extra bits by oversampling, 0..3 (e.g. 2: 16 conversions per result)
+#ifndef ADC_OVERSAMPLE
+#define ADC_OVERSAMPLE 2
+#endif
+
+// Size of the result queue, power of 2. One slot stays unused
+#ifndef ADC_QUEUE_SIZE
+#define ADC_QUEUE_SIZE 8
+#endif
+
+// Number of results dropped, because the queue was full
+extern volatile uint8_t adc_dropped;
+
+// Powers on the ADC (zzz_power_on(), see zzz.h) and starts sampling. admux
+// selects the reference and channel (ADMUX), e.g. (1 << MUX1) | (1 << MUX0)
+// for ADC3 (PB3) with VCC as reference. Disable the digital input of the
+// pin (DIDR0) to save current. Interrupts must be enabled to collect results
+void adc_init(uint8_t admux);
+
+// Stops sampling and disables the ADC
+void adc_stop(void);
+
+// Gets the latest result (10 + ADC_OVERSAMPLE bits) into value. Returns 0 if
+// there is none yet (since adc_init()), value is unchanged then
+uint8_t adc_read(uint16_t *value);
+
+// Pops the oldest result into value. Returns 0 if there is none
+uint8_t adc_pop(uint16_t *value);
+
+#ifdef ADC_TIMER0
+// Called by the Timer0 ISR every 1ms
+void adc_isr_tick(void);
+#endif
+
+#endif
@@ -21,6 +21,7 @@ SOFTWARE.
 */
 #include <avr/io.h>
 #include <util/delay.h>
+#include "../simbench.h"
 
 #define BLINK_DELAY_MS 1000
 
@@ -47,6 +48,8 @@ int main(void)
     setup();
     while (1)
     {
+        SIM_LOOP_MARK();
+
         loop();
     }
 }
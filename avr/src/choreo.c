@@ -22,12 +22,35 @@ SOFTWARE.
 #include "timemeas.h"
 #include "choreo.h"
 
+// Wake time requested by the running choreo function (choreo_wake_at())
+static uint32_t wake_time;
+
+static void choreo_call(choreo *cho, uint8_t step_old, uint32_t time)
+{
+    wake_time = time + 1;
+    cho->step = cho->func(step_old, time, cho->data);
+
+    // Never due again at the same time, this would stall choreo_sched_tick()
+    if ((int32_t)(wake_time - time) <= 0)
+    {
+        wake_time = time + 1;
+    }
+    cho->next_time = cho->start_time + wake_time;
+}
+
+static void choreo_start_at(choreo *cho, uint32_t now)
+{
+    cho->start_time = now;
+    choreo_call(cho, CHOREO_IDLE, 0);
+}
+
 void choreo_init(choreo *cho,
                  uint8_t loop,
                  const void *data,
                  uint8_t (*func)(uint8_t step_old, uint32_t time, const void *data))
 {
     cho->start_time = 0;
+    cho->next_time = 0;
     cho->step = CHOREO_IDLE;
     cho->loop = loop;
     cho->data = data;
@@ -36,17 +59,21 @@ void choreo_init(choreo *cho,
 
 void choreo_start(choreo *cho)
 {
-    cho->start_time = timemeas_now();
-    cho->step = cho->func(CHOREO_IDLE, 0, cho->data);
+    choreo_start_at(cho, timemeas_now());
 }
 
 void choreo_tick(choreo *cho)
 {
-    cho->step = cho->func(cho->step, timemeas_now() - cho->start_time, cho->data);
+    choreo_tick_at(cho, timemeas_now());
+}
+
+void choreo_tick_at(choreo *cho, uint32_t now)
+{
+    choreo_call(cho, cho->step, now - cho->start_time);
 
     if (cho->step == CHOREO_IDLE && cho->loop)
     {
-        choreo_start(cho);
+        choreo_start_at(cho, now);
     }
 }
 
@@ -54,3 +81,209 @@ void choreo_stop(choreo *cho)
 {
     cho->step = cho->func(CHOREO_RESET, 0, cho->data);
 }
+
+void choreo_wake_at(uint32_t time)
+{
+    wake_time = time;
+}
+
+// Removes cho from the queue, if queued
+static void choreo_sched_remove(choreo_sched *sched, choreo *cho)
+{
+    for (uint8_t i = 0; i < sched->len; i++)
+    {
+        if (sched->queue[i] == cho)
+        {
+            sched->len--;
+            for (; i < sched->len; i++)
+            {
+                sched->queue[i] = sched->queue[i + 1];
+            }
+            return;
+        }
+    }
+}
+
+// Inserts cho into the queue, keeping the latest deadline first.
+// The earliest deadline is at the end, so it can be taken in O(1).
+// Returns 0 if the queue is full
+static uint8_t choreo_sched_insert(choreo_sched *sched, choreo *cho)
+{
+    if (sched->len >= CHOREO_SCHED_SIZE)
+    {
+        return 0;
+    }
+
+    uint8_t i = sched->len++;
+    for (; i > 0 && (int32_t)(sched->queue[i - 1]->next_time - cho->next_time) < 0; i--)
+    {
+        sched->queue[i] = sched->queue[i - 1];
+    }
+    sched->queue[i] = cho;
+    return 1;
+}
+
+void choreo_sched_init(choreo_sched *sched)
+{
+    sched->len = 0;
+}
+
+uint8_t choreo_sched_start(choreo_sched *sched, choreo *cho)
+{
+    choreo_sched_remove(sched, cho);
+    choreo_start(cho);
+
+    if (cho->step != CHOREO_IDLE && !choreo_sched_insert(sched, cho))
+    {
+        // Never ticked, do not leave it running
+        choreo_stop(cho);
+        return 0;
+    }
+
+    return 1;
+}
+
+uint32_t choreo_sched_tick(choreo_sched *sched)
+{
+    uint32_t now = timemeas_now();
+
+    while (sched->len > 0 &&
+           (int32_t)(now - sched->queue[sched->len - 1]->next_time) >= 0)
+    {
+        choreo *cho = sched->queue[--sched->len];
+
+        choreo_tick_at(cho, now);
+
+        if (cho->step != CHOREO_IDLE)
+        {
+            choreo_sched_insert(sched, cho); // Its slot was just freed
+        }
+    }
+
+    if (sched->len == 0)
+    {
+        return now + CHOREO_FOREVER;
+    }
+
+    return sched->queue[sched->len - 1]->next_time;
+}
+
+void choreo_sched_stop(choreo_sched *sched, choreo *cho)
+{
+    choreo_sched_remove(sched, cho);
+    choreo_stop(cho);
+}
+
+// Returns the bit of cho in the active mask, or 0 if cho is not a member
+static uint8_t choreo_group_bit(choreo_group *grp, choreo *cho)
+{
+    for (uint8_t i = 0; i < grp->num; i++)
+    {
+        if (grp->members[i] == cho)
+        {
+            return (1 << i);
+        }
+    }
+    return 0;
+}
+
+void choreo_group_init(choreo_group *grp)
+{
+    grp->num = 0;
+    grp->active = 0;
+}
+
+uint8_t choreo_group_add(choreo_group *grp, choreo *cho)
+{
+    if (grp->num >= CHOREO_GROUP_SIZE)
+    {
+        return 0;
+    }
+
+    grp->members[grp->num++] = cho;
+    return 1;
+}
+
+uint8_t choreo_group_start(choreo_group *grp, choreo *cho)
+{
+    uint8_t bit = choreo_group_bit(grp, cho);
+
+    if (!bit)
+    {
+        return 0; // Not a member, it would never be ticked
+    }
+
+    choreo_start(cho);
+
+    if (cho->step != CHOREO_IDLE)
+    {
+        grp->active |= bit;
+    }
+    else
+    {
+        grp->active &= ~bit;
+    }
+
+    return 1;
+}
+
+uint32_t choreo_group_tick(choreo_group *grp)
+{
+    uint32_t now = timemeas_now();
+    uint32_t next = now + CHOREO_FOREVER;
+    uint8_t active = grp->active;
+
+    for (uint8_t i = 0; active; i++, active >>= 1)
+    {
+        if (!(active & 1))
+        {
+            continue;
+        }
+
+        choreo *cho = grp->members[i];
+
+        if ((int32_t)(now - cho->next_time) >= 0)
+        {
+            choreo_tick_at(cho, now);
+
+            if (cho->step == CHOREO_IDLE)
+            {
+                grp->active &= ~(1 << i);
+                continue;
+            }
+        }
+
+        if ((int32_t)(cho->next_time - next) < 0)
+        {
+            next = cho->next_time;
+        }
+    }
+
+    return next;
+}
+
+void choreo_group_stop(choreo_group *grp, choreo *cho)
+{
+    uint8_t bit = choreo_group_bit(grp, cho);
+
+    if (grp->active & bit)
+    {
+        choreo_stop(cho);
+        grp->active &= ~bit;
+    }
+}
+
+void choreo_group_stop_all(choreo_group *grp)
+{
+    uint8_t active = grp->active;
+
+    for (uint8_t i = 0; active; i++, active >>= 1)
+    {
+        if (active & 1)
+        {
+            choreo_stop(grp->members[i]);
+        }
+    }
+
+    grp->active = 0;
+}
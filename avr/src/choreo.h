@@ -56,12 +56,44 @@ SOFTWARE.
 // 6) Stop the choreo if desired:
 //   choreo_stop(&choreo_blink);
 // The choreo function will be called with step=CHOREO_RESET. It should return CHOREO_IDLE afterwards.
+//
+// Deadline scheduling (optional):
+// A choreo function may call choreo_wake_at() with the time (same time base as the time argument)
+// at which its step changes next. Without this call, it is due again 1ms later.
+// A choreo_sched keeps the running choreos sorted by this deadline and only ticks those that are due:
+//   choreo_sched sched;
+//   choreo_sched_init(&sched);
+//   choreo_sched_start(&sched, &choreo_blink);
+//   uint32_t next = choreo_sched_tick(&sched); // nothing is due before next
+//   choreo_sched_stop(&sched, &choreo_blink);
+//
+// Choreo groups (optional):
+// A choreo_group registers a fixed set of choreos and keeps a bitmask of the running ones.
+// Ticking the group reads the time once and only ticks running choreos that are due.
+// Stopping the group only stops running choreos:
+//   choreo_group group;
+//   choreo_group_init(&group);
+//   choreo_group_add(&group, &choreo_blink);
+//   choreo_group_start(&group, &choreo_blink);
+//   uint32_t next = choreo_group_tick(&group); // nothing is due before next
+//   choreo_group_stop_all(&group);
+// Members must be started and stopped via the group, to keep the bitmask valid.
 #define CHOREO_RESET 0xfe
 #define CHOREO_IDLE 0xff
 
+// Max. number of choreos running in one choreo_sched
+#define CHOREO_SCHED_SIZE 8
+
+// Max. number of choreos in one choreo_group (bits of the active mask)
+#define CHOREO_GROUP_SIZE 8
+
+// Returned by choreo_sched_tick()/choreo_group_tick() (added to the current time), if no choreo is running
+#define CHOREO_FOREVER 0x7fffffff
+
 typedef struct
 {
     uint32_t start_time;
+    uint32_t next_time; // time [ms] (timemeas_now()) the choreo is due next
     uint8_t step;
     uint8_t loop;
     const void *data;
@@ -79,4 +111,54 @@ void choreo_tick(choreo *cho);
 
 void choreo_stop(choreo *cho);
 
+// Like choreo_tick(), with the current time passed in
+void choreo_tick_at(choreo *cho, uint32_t now);
+
+// Called by a choreo function: request the next call at time [ms] (relative to the choreo start)
+void choreo_wake_at(uint32_t time);
+
+typedef struct
+{
+    choreo *queue[CHOREO_SCHED_SIZE]; // running choreos, latest deadline first
+    uint8_t len;
+} choreo_sched;
+
+void choreo_sched_init(choreo_sched *sched);
+
+// Starts the choreo and adds it to the scheduler (restarts it, if already running).
+// Returns 0 if the scheduler is full (CHOREO_SCHED_SIZE), the choreo is stopped again then
+uint8_t choreo_sched_start(choreo_sched *sched, choreo *cho);
+
+// Ticks all choreos that are due. Returns the time [ms] until which no choreo is due
+uint32_t choreo_sched_tick(choreo_sched *sched);
+
+// Removes the choreo from the scheduler and stops it
+void choreo_sched_stop(choreo_sched *sched, choreo *cho);
+
+typedef struct
+{
+    choreo *members[CHOREO_GROUP_SIZE];
+    uint8_t num;
+    uint8_t active; // bit i is set if members[i] is running
+} choreo_group;
+
+void choreo_group_init(choreo_group *grp);
+
+// Registers an (initialized, not running) choreo in the group.
+// Returns 0 if the group is full (CHOREO_GROUP_SIZE)
+uint8_t choreo_group_add(choreo_group *grp, choreo *cho);
+
+// Starts a member of the group (restarts it, if already running).
+// Returns 0 if cho is not a member, it is not started then
+uint8_t choreo_group_start(choreo_group *grp, choreo *cho);
+
+// Ticks all running members that are due. Returns the time [ms] until which no member is due
+uint32_t choreo_group_tick(choreo_group *grp);
+
+// Stops a member of the group, if it is running
+void choreo_group_stop(choreo_group *grp, choreo *cho);
+
+// Stops all running members of the group
+void choreo_group_stop_all(choreo_group *grp);
+
 #endif
@@ -23,97 +23,87 @@ SOFTWARE.
 #include <avr/interrupt.h>
 #include <avr/io.h>
 #include "../timemeas.h"
-#include "../choreo.h"
+#include "../choreo_static.h"
+#include "../choreo_keyframes.h"
 #include "../debounce.h"
+#include "../flash.h"
+#include "../simbench.h"
 
-uint8_t choreo_func_blink(uint8_t step_old, uint32_t time, const void *data)
-{
-    // Reset requested: Go to idle state
-    if (step_old == CHOREO_RESET)
-    {
-        PORTB &= ~(1 << PB1);
-        return CHOREO_IDLE;
-    }
+// Keyframe actions (see choreo_keyframes.h), arg: PORTB pin mask
+#define PINS_ON 0
+#define PINS_OFF 1
 
-    // Increment step by time
-    uint8_t step = (uint8_t)(time >> 8);
-    if (step == step_old)
-    {
-        return step;
-    }
-
-    // Handle step increment
-    switch (step)
-    {
-    case 0:
-        PORTB |= (1 << PB1);
-        return step;
-    case 1:
-        PORTB &= ~(1 << PB1);
-        return step;
-    case 2:
-    default:
-        return CHOREO_IDLE; // finish choreo
-    }
-}
-
-uint8_t choreo_func_morse(uint8_t step_old, uint32_t time, const void *data)
+void pins_action(uint8_t action, uint8_t arg)
 {
-    // ['t', 'i', 'n', 'y'] (waste of memory)
-    static const uint8_t signal[] = {1, 1, 1, 0, 0, 0,
-                                     1, 0, 1, 0, 0, 0,
-                                     1, 1, 1, 0, 1, 0, 0, 0,
-                                     1, 1, 1, 0, 1, 0, 1, 1, 1, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
-    static const uint8_t signal_size = sizeof(signal) / sizeof(signal[0]);
-
-    // Reset requested: Go to idle state
-    if (step_old == CHOREO_RESET)
-    {
-        PORTB &= ~(1 << PB2);
-        return CHOREO_IDLE;
-    }
-
-    // Increment step by time
-    uint8_t step = (uint8_t)(time >> 7);
-    if (step == step_old)
+    if (action == PINS_ON)
     {
-        return step;
-    }
-
-    if (step >= signal_size)
-    {
-        return CHOREO_IDLE; // finish choreo
-    }
-    else if (signal[step])
-    {
-        PORTB |= (1 << PB2);
+        PORTB |= arg;
     }
     else
     {
-        PORTB &= ~(1 << PB2);
+        PORTB &= ~arg;
     }
+}
 
-    return step;
+// Blinks PB1
+const choreo_keyframe show_blink[] FLASH = {
+    CHOREO_KF_ON_STOP(PINS_OFF, 1 << PB1),
+    {0, PINS_ON, 1 << PB1},
+    {256, PINS_OFF, 1 << PB1},
+    {512, CHOREO_KF_END, 0},
+};
+
+// ['t', 'i', 'n', 'y'] in Morse code on PB2, 128ms per unit
+const choreo_keyframe show_morse[] FLASH = {
+    CHOREO_KF_ON_STOP(PINS_OFF, 1 << PB2),
+    // t
+    {0, PINS_ON, 1 << PB2},
+    {384, PINS_OFF, 1 << PB2},
+    // i
+    {768, PINS_ON, 1 << PB2},
+    {896, PINS_OFF, 1 << PB2},
+    {1024, PINS_ON, 1 << PB2},
+    {1152, PINS_OFF, 1 << PB2},
+    // n
+    {1536, PINS_ON, 1 << PB2},
+    {1920, PINS_OFF, 1 << PB2},
+    {2048, PINS_ON, 1 << PB2},
+    {2176, PINS_OFF, 1 << PB2},
+    // y
+    {2560, PINS_ON, 1 << PB2},
+    {2944, PINS_OFF, 1 << PB2},
+    {3072, PINS_ON, 1 << PB2},
+    {3200, PINS_OFF, 1 << PB2},
+    {3328, PINS_ON, 1 << PB2},
+    {3712, PINS_OFF, 1 << PB2},
+    {3840, PINS_ON, 1 << PB2},
+    {4224, PINS_OFF, 1 << PB2},
+    {5120, CHOREO_KF_END, 0},
+};
+
+// Plays the show passed as data
+uint8_t choreo_func_show(uint8_t step_old, uint32_t time, const void *data)
+{
+    return choreo_kf_play(step_old, time, (const choreo_keyframe *)data, pins_action);
 }
 
+// All choreos, dispatched statically (see choreo_static.h)
+// blink loops, Morse is performed once
+#define CHOREO_LIST(X)                            \
+    X(blink, choreo_func_show, 1, show_blink) \
+    X(morse, choreo_func_show, 0, show_morse)
+#include "../choreo_static.h"
+
 int main(void)
 {
-    debouncer button_deb_blink;
-    debouncer button_deb_morse;
-    debounce_init(&button_deb_blink);
-    debounce_init(&button_deb_morse);
-
-    choreo choreo_blink;
-    choreo choreo_morse;
+    // Both buttons are debounced at once
+    debouncer_pins buttons;
+    debounce_pins_init(&buttons);
+    uint32_t last_sample_time = 0;
 
     timemeas_init();
     sei();
 
-    // Init blink choreo: loop=1
-    choreo_init(&choreo_blink, 1, 0, choreo_func_blink);
-    // Init Morse choreo: perform once (loop=0)
-    choreo_init(&choreo_morse, 0, 0, choreo_func_morse);
-
     // PB1, PB2: out
     DDRB |= (1 << DDB1) | (1 << DDB2);
 
@@ -125,41 +115,42 @@ int main(void)
 
     while (1)
     {
-        if (choreo_blink.step != CHOREO_IDLE)
-        {
-            choreo_tick(&choreo_blink);
-        }
+        SIM_LOOP_MARK();
+
+        // Ticks the running choreos that are due
+        choreo_static_tick();
 
-        if (choreo_morse.step != CHOREO_IDLE)
+        // Sample buttons (to GND: pressed reads LOW) at a fixed rate
+        if (timemeas_now() - last_sample_time < DEBOUNCE_PINS_INTERVAL)
         {
-            choreo_tick(&choreo_morse);
+            continue;
         }
+        last_sample_time = timemeas_now();
+        debounce_pins_update(~PINB & ((1 << PINB3) | (1 << PINB4)), &buttons);
 
         // Toggle blink choreo
-        debounce_update((PINB & (1 << PINB3)) ? 0 : 1, &button_deb_blink);
-        if (button_deb_blink.state_changed && button_deb_blink.state == 1)
+        if (buttons.pressed & (1 << PINB3))
         {
-            if (choreo_blink.step == CHOREO_IDLE)
+            if (choreo_static_step(CHOREO_ID(blink)) == CHOREO_IDLE)
             {
-                choreo_start(&choreo_blink);
+                choreo_static_start(CHOREO_ID(blink));
             }
             else
             {
-                choreo_stop(&choreo_blink);
+                choreo_static_stop(CHOREO_ID(blink));
             }
         }
 
         // Toggle Morse choreo
-        debounce_update((PINB & (1 << PINB4)) ? 0 : 1, &button_deb_morse);
-        if (button_deb_morse.state_changed && button_deb_morse.state == 1)
+        if (buttons.pressed & (1 << PINB4))
         {
-            if (choreo_morse.step == CHOREO_IDLE)
+            if (choreo_static_step(CHOREO_ID(morse)) == CHOREO_IDLE)
             {
-                choreo_start(&choreo_morse);
+                choreo_static_start(CHOREO_ID(morse));
             }
             else
             {
-                choreo_stop(&choreo_morse);
+                choreo_static_stop(CHOREO_ID(morse));
             }
         }
     }
@@ -0,0 +1,109 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef CHOREO_KEYFRAMES_H
+#define CHOREO_KEYFRAMES_H
+
+#include <stdint.h>
+#include "choreo.h"
+#include "flash.h"
+
+// Keyframe choreos: a light show (or any other output sequence) is a table of
+// keyframes in flash, played by one generic choreo function, instead of a
+// hand-written step function per show.
+//
+// 1) Define the actions of the firmware, and a handler performing them:
+//   #define LED_ON 0
+//   #define LED_OFF 1
+//   void led_action(uint8_t action, uint8_t arg) { ... }
+//
+// 2) Define the shows. Row 0 is applied when the choreo is stopped, playback
+// starts with row 1 at time 0. Times [ms] are relative to the choreo start,
+// a CHOREO_KF_END row ends the choreo (or restarts it, if it loops):
+//   const choreo_keyframe blink[] FLASH = {
+//       CHOREO_KF_ON_STOP(LED_OFF, 0),
+//       {0, LED_ON, 0},
+//       {256, LED_OFF, 0},
+//       {512, CHOREO_KF_END, 0},
+//   };
+//
+// 3) Define the choreo function, and pass a show as data (choreo_init() or
+// choreo_static.h):
+//   uint8_t choreo_func_show(uint8_t step_old, uint32_t time, const void *data)
+//   {
+//       return choreo_kf_play(step_old, time, (const choreo_keyframe *)data, led_action);
+//   }
+//
+// The step is the cursor (table row of the last applied keyframe, row 0 until
+// the first one is due), so each call only looks at the next keyframe,
+// independent of the show length. The first keyframe may come after time 0.
+// Up to 253 rows. With choreo_static.h, include it before this header.
+
+// Action of the last row of a show
+#define CHOREO_KF_END 0xff
+
+// Row 0 of a show: action applied when the choreo is stopped
+#define CHOREO_KF_ON_STOP(action, arg) {0, (action), (arg)}
+
+typedef struct
+{
+    uint16_t time; // [ms] since the choreo start
+    uint8_t action;
+    uint8_t arg;
+} choreo_keyframe;
+
+// Performs an action of a keyframe
+typedef void (*choreo_kf_action)(uint8_t action, uint8_t arg);
+
+// Plays a show (FLASH) with the handler act. Call it from a choreo function.
+static inline uint8_t choreo_kf_play(uint8_t step_old, uint32_t time, const choreo_keyframe *show, choreo_kf_action act)
+{
+    if (step_old == CHOREO_RESET)
+    {
+        act(flash_u8(&show[0].action), flash_u8(&show[0].arg));
+        return CHOREO_IDLE;
+    }
+
+    // Apply all keyframes that are due. Usually none or one per call,
+    // more if the call was late. Started: the cursor is on row 0 (not
+    // CHOREO_IDLE, which would end the choreo if row 1 is not due yet)
+    uint8_t step = (step_old == CHOREO_IDLE) ? 0 : step_old;
+    uint8_t next = step + 1;
+    uint16_t next_time = flash_u16(&show[next].time);
+
+    while (time >= next_time)
+    {
+        uint8_t action = flash_u8(&show[next].action);
+        if (action == CHOREO_KF_END)
+        {
+            return CHOREO_IDLE;
+        }
+
+        act(action, flash_u8(&show[next].arg));
+        step = next++;
+        next_time = flash_u16(&show[next].time);
+    }
+
+    choreo_wake_at(next_time);
+    return step;
+}
+
+#endif
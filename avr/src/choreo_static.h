@@ -0,0 +1,223 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef CHOREO_STATIC_H
+#define CHOREO_STATIC_H
+
+#include <stdint.h>
+#include "timemeas.h"
+#include "choreo.h"
+
+// Statically declared choreos (alternative to choreo_group, see choreo.h).
+//
+// All choreos of a firmware are listed at compile time. Function, loop flag and
+// data are constants, so only the times and the step are kept in SRAM, and
+// choreo_static_tick() calls the choreo functions directly (switch), instead of
+// via a function pointer. The choreo functions are the same as for choreo.h.
+//
+// 1) Include this header before the choreo functions (it redirects choreo_wake_at()).
+// 2) Define the choreos, then include this header again:
+//   #define CHOREO_LIST(X) X(blink, choreo_func_blink, 1, 0) X(morse, choreo_func_morse, 0, &morse_data)
+//   #include "../choreo_static.h"
+// X(name, func, loop, data): loop and data like choreo_init(). Continue long lists with backslashes.
+// 3) Use the choreos by their id CHOREO_ID(name):
+//   choreo_static_start(CHOREO_ID(blink));
+//   uint32_t next = choreo_static_tick(); // nothing is due before next
+//   if (choreo_static_step(CHOREO_ID(blink)) == CHOREO_IDLE) { ... }
+//   choreo_static_stop(CHOREO_ID(blink));
+//   choreo_static_stop_all();
+// Up to 8 choreos. Do not link choreo.c, if only static choreos are used.
+//
+// With CHOREO_TIME16 defined (e.g. in the Makefile), start and due times are
+// kept in 16 bits: 5 instead of 9 bytes of SRAM per choreo, and cheaper
+// comparisons. The time passed to a choreo function then wraps around after
+// 65.5s, and choreo_wake_at() must not be more than 32s ahead.
+
+#define CHOREO_ID(name) choreo_id_##name
+
+#ifdef CHOREO_TIME16
+typedef uint16_t choreo_static_time;
+typedef int16_t choreo_static_dtime;
+#else
+typedef uint32_t choreo_static_time;
+typedef int32_t choreo_static_dtime;
+#endif
+
+// Wake time requested by the running choreo function
+static uint32_t choreo_static_wake;
+#define choreo_wake_at(time) (choreo_static_wake = (time))
+
+#endif
+
+#if defined(CHOREO_LIST) && !defined(CHOREO_STATIC_LIST_DONE)
+#define CHOREO_STATIC_LIST_DONE
+
+#define CHOREO_STATIC_ENUM(name, func, loop, data) CHOREO_ID(name),
+enum
+{
+    CHOREO_LIST(CHOREO_STATIC_ENUM)
+    CHOREO_STATIC_COUNT
+};
+#undef CHOREO_STATIC_ENUM
+
+#if CHOREO_STATIC_COUNT > 8
+#error choreo_static supports up to 8 choreos
+#endif
+
+// Bit i is set if choreo i loops
+#define CHOREO_STATIC_LOOP(name, func, loop, data) | ((loop) ? (1 << CHOREO_ID(name)) : 0)
+enum
+{
+    choreo_static_loop_mask = 0 CHOREO_LIST(CHOREO_STATIC_LOOP)
+};
+#undef CHOREO_STATIC_LOOP
+
+static struct
+{
+    choreo_static_time start_time;
+    choreo_static_time next_time; // time [ms] (timemeas_now()) the choreo is due next
+    uint8_t step;
+} choreo_static_state[CHOREO_STATIC_COUNT];
+
+// Bit i is set if choreo i is running
+static uint8_t choreo_static_active;
+
+static inline uint8_t choreo_static_dispatch(uint8_t id, uint8_t step_old, uint32_t time)
+{
+#define CHOREO_STATIC_CASE(name, func, loop, data) \
+    case CHOREO_ID(name):                          \
+        return func(step_old, time, (const void *)(data));
+
+    switch (id)
+    {
+        CHOREO_LIST(CHOREO_STATIC_CASE)
+    default:
+        return CHOREO_IDLE;
+    }
+
+#undef CHOREO_STATIC_CASE
+}
+
+static inline void choreo_static_call(uint8_t id, uint8_t step_old, choreo_static_time time)
+{
+    choreo_static_wake = time + 1;
+    uint8_t step = choreo_static_dispatch(id, step_old, time);
+    choreo_static_state[id].step = step;
+
+    // Never due again at the same time, this would stall choreo_static_tick()
+    if ((choreo_static_dtime)(choreo_static_wake - time) <= 0)
+    {
+        choreo_static_wake = time + 1;
+    }
+    choreo_static_state[id].next_time = choreo_static_state[id].start_time + choreo_static_wake;
+
+    if (step == CHOREO_IDLE)
+    {
+        choreo_static_active &= ~(1 << id);
+    }
+    else
+    {
+        choreo_static_active |= (1 << id);
+    }
+}
+
+static inline void choreo_static_start_at(uint8_t id, choreo_static_time now)
+{
+    choreo_static_state[id].start_time = now;
+    choreo_static_call(id, CHOREO_IDLE, 0);
+}
+
+// Returns the current step of a choreo, CHOREO_IDLE if it is not running
+static inline uint8_t choreo_static_step(uint8_t id)
+{
+    return (choreo_static_active & (1 << id)) ? choreo_static_state[id].step : CHOREO_IDLE;
+}
+
+// Starts a choreo (restarts it, if already running)
+static inline void choreo_static_start(uint8_t id)
+{
+    choreo_static_start_at(id, timemeas_now());
+}
+
+// Stops a choreo, if it is running
+static inline void choreo_static_stop(uint8_t id)
+{
+    if (choreo_static_active & (1 << id))
+    {
+        choreo_static_dispatch(id, CHOREO_RESET, 0);
+        choreo_static_active &= ~(1 << id);
+    }
+}
+
+// Stops all running choreos
+static inline void choreo_static_stop_all(void)
+{
+    for (uint8_t id = 0; id < CHOREO_STATIC_COUNT; id++)
+    {
+        choreo_static_stop(id);
+    }
+}
+
+// Ticks all running choreos that are due. Returns the time [ms] until which no choreo is due.
+// Not inlined, so that it keeps its symbol for the cycle benchmark (avr/sim).
+// Unused: like an inline function, no warning if a firmware does not call it
+static __attribute__((noinline, unused)) uint32_t choreo_static_tick(void)
+{
+    const uint32_t now32 = timemeas_now();
+    const choreo_static_time now = now32;
+    choreo_static_dtime until_next = (choreo_static_dtime)(CHOREO_FOREVER >> (32 - 8 * sizeof(choreo_static_time)));
+
+    for (uint8_t id = 0; id < CHOREO_STATIC_COUNT; id++)
+    {
+        if (!(choreo_static_active & (1 << id)))
+        {
+            continue;
+        }
+
+        if ((choreo_static_dtime)(now - choreo_static_state[id].next_time) >= 0)
+        {
+            choreo_static_call(id, choreo_static_state[id].step, now - choreo_static_state[id].start_time);
+
+            if (choreo_static_state[id].step == CHOREO_IDLE)
+            {
+                if (!(choreo_static_loop_mask & (1 << id)))
+                {
+                    continue;
+                }
+                choreo_static_start_at(id, now);
+                if (choreo_static_state[id].step == CHOREO_IDLE)
+                {
+                    continue;
+                }
+            }
+        }
+
+        choreo_static_dtime until = choreo_static_state[id].next_time - now;
+        if (until < until_next)
+        {
+            until_next = until;
+        }
+    }
+
+    return now32 + until_next;
+}
+
+#endif
@@ -22,6 +22,11 @@ SOFTWARE.
 #include "timemeas.h"
 #include "debounce.h"
 
+#ifdef DEBOUNCE_ISR_PINS
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
 void debounce_init(debouncer *deb)
 {
     deb->state = 0;
@@ -46,3 +51,108 @@ void debounce_update(uint8_t state, debouncer *deb)
         deb->last_change_time = now;
     }
 }
+
+void debounce_pins_init(debouncer_pins *deb)
+{
+    deb->state = 0;
+    deb->ct0 = 0xff;
+    deb->ct1 = 0xff;
+    deb->pressed = 0;
+    deb->released = 0;
+}
+
+void debounce_pins_update(uint8_t sample, debouncer_pins *deb)
+{
+    // Pins differing from the debounced state
+    uint8_t delta = sample ^ deb->state;
+
+    // Count down (3, 2, 1, 0) while differing, reset to 3 otherwise
+    uint8_t ct0 = ~(deb->ct0 & delta);
+    uint8_t ct1 = ct0 ^ (deb->ct1 & delta);
+    deb->ct0 = ct0;
+    deb->ct1 = ct1;
+
+    // Counter wrapped (0 -> 3): take over the sample
+    uint8_t toggle = delta & ct0 & ct1;
+    deb->state ^= toggle;
+
+    deb->pressed = deb->state & toggle;
+    deb->released = ~deb->state & toggle;
+}
+
+#ifdef DEBOUNCE_ISR_PINS
+
+#if (DEBOUNCE_ISR_QUEUE_SIZE & (DEBOUNCE_ISR_QUEUE_SIZE - 1)) != 0
+#error DEBOUNCE_ISR_QUEUE_SIZE must be a power of 2
+#endif
+
+// Single producer (ISR), single consumer (main loop) ring buffer.
+// Each index is only written by one side, and 8 bit accesses are atomic,
+// so no locking is required.
+static debouncer_pins isr_deb = {0, 0xff, 0xff, 0, 0};
+static debounce_event isr_queue[DEBOUNCE_ISR_QUEUE_SIZE];
+static volatile uint8_t isr_head = 0; // next slot to write, ISR only
+static volatile uint8_t isr_tail = 0; // next slot to read, main loop only
+volatile uint8_t debounce_isr_dropped = 0;
+static uint8_t isr_sample_ctr = 0;
+
+uint8_t debounce_isr_tick(uint32_t now)
+{
+    if (++isr_sample_ctr < DEBOUNCE_PINS_INTERVAL)
+    {
+        return 0;
+    }
+    isr_sample_ctr = 0;
+
+    debounce_pins_update(~PINB & (DEBOUNCE_ISR_PINS), &isr_deb);
+    if (!(isr_deb.pressed | isr_deb.released))
+    {
+        return 0;
+    }
+
+    uint8_t head = isr_head;
+    uint8_t next = (head + 1) & (DEBOUNCE_ISR_QUEUE_SIZE - 1);
+    if (next == isr_tail)
+    {
+        debounce_isr_dropped++;
+        return 0;
+    }
+
+    isr_queue[head].time = now;
+    isr_queue[head].pressed = isr_deb.pressed;
+    isr_queue[head].released = isr_deb.released;
+
+    // Publish the slot only after it is written
+    __asm__ volatile("" ::: "memory");
+    isr_head = next;
+    return 1;
+}
+
+uint8_t debounce_isr_pop(debounce_event *ev)
+{
+    uint8_t tail = isr_tail;
+    if (tail == isr_head)
+    {
+        return 0;
+    }
+
+    *ev = isr_queue[tail];
+
+    // Release the slot only after it is read
+    __asm__ volatile("" ::: "memory");
+    isr_tail = (tail + 1) & (DEBOUNCE_ISR_QUEUE_SIZE - 1);
+    return 1;
+}
+
+void debounce_isr_reset(uint8_t state)
+{
+    uint8_t sreg = SREG;
+    cli();
+    isr_deb.state = state & (DEBOUNCE_ISR_PINS);
+    isr_deb.ct0 = 0xff;
+    isr_deb.ct1 = 0xff;
+    isr_tail = isr_head;
+    SREG = sreg;
+}
+
+#endif
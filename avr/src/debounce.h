@@ -37,4 +37,70 @@ void debounce_init(debouncer *deb);
 
 void debounce_update(uint8_t state, debouncer *deb);
 
+// Debouncer for up to 8 pins (e.g. all PORTB inputs) at once.
+// Each pin has a 2 bit counter, stored "vertically" in two bytes (ct0, ct1),
+// so that all pins are updated with a few byte operations per sample.
+// A pin level is taken over after DEBOUNCE_PINS_SAMPLES equal samples, which
+// differ from the debounced state. Call debounce_pins_update() at a fixed
+// rate, e.g. every DEBOUNCE_PINS_INTERVAL ms:
+//   debounce_pins_update(~PINB & ((1 << PINB3) | (1 << PINB4)), &buttons);
+//   if (buttons.pressed & (1 << PINB3)) { ... }
+#define DEBOUNCE_PINS_SAMPLES 4
+
+// Suggested sample interval [ms]
+#define DEBOUNCE_PINS_INTERVAL 10
+
+typedef struct
+{
+    uint8_t state;    // debounced levels, 1: active
+    uint8_t ct0;      // counter bit 0 of each pin
+    uint8_t ct1;      // counter bit 1 of each pin
+    uint8_t pressed;  // pins that became active in the last update
+    uint8_t released; // pins that became inactive in the last update
+} debouncer_pins;
+
+void debounce_pins_init(debouncer_pins *deb);
+
+// sample: raw levels, 1: active (e.g. ~PINB for buttons to GND)
+void debounce_pins_update(uint8_t sample, debouncer_pins *deb);
+
+// Debouncing in the Timer0 ISR (optional):
+// Define DEBOUNCE_ISR_PINS (mask of PORTB pins, buttons to GND, e.g. in the
+// Makefile CDEFS) to sample these pins every DEBOUNCE_PINS_INTERVAL ms in
+// TIMER0_COMPA_vect (timemeas.c) with a debouncer_pins. Each update with
+// edges is queued as a debounce_event, with its time. Input latency then
+// does not depend on the main loop, it only has to pop the events. A queued
+// event ends timemeas_sleep_until(), like an interrupt:
+//   debounce_event ev;
+//   while (debounce_isr_pop(&ev)) { if (ev.pressed & (1 << PB2)) { ... } }
+// If the queue is full, new events are dropped and counted.
+#ifdef DEBOUNCE_ISR_PINS
+
+// Size of the event queue, power of 2. One slot stays unused
+#ifndef DEBOUNCE_ISR_QUEUE_SIZE
+#define DEBOUNCE_ISR_QUEUE_SIZE 8
+#endif
+
+typedef struct
+{
+    uint32_t time;    // [ms] (timemeas_now()) of the sample
+    uint8_t pressed;  // pins that became active
+    uint8_t released; // pins that became inactive
+} debounce_event;
+
+// Number of events dropped, because the queue was full
+extern volatile uint8_t debounce_isr_dropped;
+
+// Called by the Timer0 ISR every 1ms. Returns 1 if an event was queued
+uint8_t debounce_isr_tick(uint32_t now);
+
+// Pops the oldest event into ev. Returns 0 if there is none
+uint8_t debounce_isr_pop(debounce_event *ev);
+
+// Drops all events and sets the debounced levels (1: active), e.g. after
+// a wake-up by a button press, which shall not be reported
+void debounce_isr_reset(uint8_t state);
+
+#endif
+
 #endif
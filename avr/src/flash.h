@@ -0,0 +1,58 @@
+/*
+Copyright (c) 2026 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef FLASH_H
+#define FLASH_H
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+// Constant tables in flash instead of SRAM.
+//
+// On AVR, a plain const table is copied to SRAM at startup (.data). Tables
+// declared with FLASH stay in flash, but must be read with the accessors:
+//   const uint8_t table[] FLASH = {1, 2, 3};
+//   uint8_t value = flash_u8(&table[i]);
+// Pointers stored in a FLASH table (e.g. to another FLASH table) are read
+// with flash_ptr(). Everything read this way must be declared with FLASH.
+#define FLASH PROGMEM
+
+static inline uint8_t flash_u8(const void *addr)
+{
+    return pgm_read_byte(addr);
+}
+
+static inline uint16_t flash_u16(const void *addr)
+{
+    return pgm_read_word(addr);
+}
+
+static inline uint32_t flash_u32(const void *addr)
+{
+    return pgm_read_dword(addr);
+}
+
+static inline const void *flash_ptr(const void *addr)
+{
+    return pgm_read_ptr(addr);
+}
+
+#endif
@@ -0,0 +1,75 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef GAMMA_H
+#define GAMMA_H
+
+#include <stdint.h>
+#include "flash.h"
+
+// Gamma correction and global brightness for LED color values.
+//
+// Palettes use the full 8 bit range, in perceived brightness. A value v is
+// output as gamma_lut[(v * brightness) >> 8]: scaling keeps the hue of a
+// color at any brightness, and the gamma curve (2.2) makes the steps look even.
+//
+// The ATtiny85 has no MUL instruction, so the scaling is done by shift-add.
+// Cycle budget per value (@ 8MHz, estimated):
+//   gamma_scale()  up to 8 shift-add steps      ~80 cycles (10us)
+//   gamma_lut      flash lookup                  ~7 cycles
+// This does not fit into the send path: per pixel, it would exceed the
+// generator budget of ws2812b_send_stream() (WS2812B_GEN_BUDGET_CYCLES).
+// Instead, gamma_palette() converts a palette once per brightness change
+// (e.g. 8 colors: ~2100 cycles, 0.3ms), and the frames are rendered from
+// the converted palette in SRAM.
+
+// Gamma 2.2, in flash
+extern const uint8_t gamma_lut[256];
+
+// Returns (v * brightness) >> 8
+static inline uint8_t gamma_scale(uint8_t v, uint8_t brightness)
+{
+    uint16_t acc = 0;
+    uint16_t addend = v;
+
+    while (brightness)
+    {
+        if (brightness & 1)
+        {
+            acc += addend;
+        }
+        addend <<= 1;
+        brightness >>= 1;
+    }
+
+    return acc >> 8;
+}
+
+// Returns the output value of v at brightness
+static inline uint8_t gamma_level(uint8_t v, uint8_t brightness)
+{
+    return flash_u8(&gamma_lut[gamma_scale(v, brightness)]);
+}
+
+// Converts num colors of palette src (FLASH) to dst (SRAM) at brightness
+void gamma_palette(const uint8_t (*src)[3], uint8_t (*dst)[3], uint8_t num, uint8_t brightness);
+
+#endif
@@ -21,16 +21,40 @@ SOFTWARE.
 */
 #include <stdint.h>
 #include <avr/io.h>
-#include <util/delay.h>
 #include <avr/interrupt.h>
+#include <util/delay.h>
 #include "../ws2812b.h"
 #include "../timemeas.h"
-#include "../choreo.h"
+#include "../choreo_static.h"
+#include "../choreo_keyframes.h"
 #include "../zzz.h"
+#include "../flash.h"
+#include "../gamma.h"
+#include "../telemetry.h"
+#include "../pinlatch.h"
+#include "../simbench.h"
 
 // Config
 #define NUM_LED 10
 #define TIME_UNTIL_SLEEP 90000 // [ms] Go to sleep mode if no input for TIME_UNTIL_SLEEP ms
+#define FRAME_INTERVAL 16      // [ms] min. time between two LED transfers
+#define LED_BRIGHTNESS 135     // 0..255, see gamma.h
+
+// Telemetry (make TELEMETRY=1), see telemetry.h.
+// There is no spare pin (PB5 is RESET), so the UART shares PB1 with the
+// buzzer. Frames are only sent while no melody is playing, and PB1 is only
+// HIGH (UART idle) around a frame, LOW otherwise as without telemetry.
+// Each frame (~70 bytes, ~6ms at 115200 baud) is audible as a faint click
+// of the buzzer, once per TELEMETRY_INTERVAL.
+#define TELEMETRY_SOURCE 1
+#define TELEMETRY_INTERVAL 1000 // [ms]
+#define TELEMETRY_IDLE_US 100   // UART idle (HIGH) before a frame, > 1 byte
+#define TELEMETRY_LOOPS 0       // counter: main loop passes
+#define TELEMETRY_GAMES 1       // counter: games started
+#define TELEMETRY_WAKEUPS 2     // counter: wake-ups from sleep
+#define TELEMETRY_ZZZ 4         // counters 4..7: time [ms] per sleep state (make ZZZ_STATS=1)
+#define TELEMETRY_TICK_US 0     // histogram: choreo_static_tick() run time
+#define TELEMETRY_LOOP_US 1     // histogram: main loop pass run time
 
 // Stages
 #define STATE_IDLE 1
@@ -38,19 +62,23 @@ SOFTWARE.
 #define STATE_WON 3
 #define STATE_LOST 4
 
+// Wire and goal pad, latched in the pin change interrupt while playing
+#define HIT_PINS ((1 << PB0) | (1 << PB4))
+
 // Audio
 // ToDo: check for F_CPU == 8000000 and assume PRESCALER from F_CPU
 #define PRESCALER 1024
 #define OCR1C_FROM_FREQ(freq) ((F_CPU / (2UL * PRESCALER * (uint32_t)(freq))) - 1)
 
+// Melodies are stored in flash, see flash.h
 typedef struct
 {
     uint8_t ctr_top;   // top value for OCR1C
-    uint32_t duration; // [ms]
+    uint16_t duration; // [ms]
 } cnote_t;
 
 // Melody: start
-const cnote_t melody_start[] = {
+const cnote_t melody_start[] FLASH = {
     {9, 100},
     {0, 100},
     {9, 100},
@@ -58,7 +86,7 @@ const cnote_t melody_start[] = {
 };
 
 // Melody: success
-const cnote_t melody_success[] = {
+const cnote_t melody_success[] FLASH = {
     {OCR1C_FROM_FREQ(523), 250},
     {OCR1C_FROM_FREQ(659), 250},
     {OCR1C_FROM_FREQ(784), 250},
@@ -74,263 +102,264 @@ const cnote_t melody_success[] = {
 };
 
 // Melody: lost
-const cnote_t melody_lost[] = {
+const cnote_t melody_lost[] FLASH = {
     {13, 250},
     {0, 100},
     {17, 750},
     {0xff, 0} // END
 };
 
-// ToDo: merge the choreo light functions, pass color data via data
-
-uint8_t choreo_func_lost_light(uint8_t step_old, uint32_t time, const void *data)
+// Playback state of a melody, passed to choreo_func_melody() as data
+typedef struct
 {
-    // Reset requested: Go to idle state
-    if (step_old == CHOREO_RESET)
+    const cnote_t *melody; // FLASH
+    uint32_t note_end; // [ms] end of the current note, relative to the melody start
+} melody_player;
+
+melody_player player_start = {melody_start, 0};
+melody_player player_success = {melody_success, 0};
+melody_player player_lost = {melody_lost, 0};
+
+// LED colors (GRB), up to 16 (4 bit frame buffer). Full range, output at
+// LED_BRIGHTNESS with gamma correction (palette_out, see gamma.h)
+const uint8_t palette[][3] FLASH = {
+    {255, 0, 0},   // Green
+    {255, 255, 0}, // Yellow
+    {168, 255, 0}, // Orange
+    {0, 255, 0},   // Red
+    {0, 158, 158}, // Pink
+    {137, 0, 205}, // Blue
+    {0, 0, 0},     // Off
+    {0, 255, 0},   // Red (lost)
+    {0, 255, 255}, // Magenta
+};
+#define NUM_COLORS (sizeof(palette) / sizeof(palette[0]))
+#define COLOR_OFF 6
+#define COLOR_LOST 7
+#define COLOR_DOT 8
+
+// palette at LED_BRIGHTNESS, gamma corrected
+uint8_t palette_out[NUM_COLORS][3];
+
+// Rainbow of the success light (palette indices), rotated along the LEDs
+const uint8_t rainbow[] FLASH = {0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5};
+#define LEN_RAINBOW 12
+
+// Keyframe actions of the light shows (see choreo_keyframes.h)
+#define LIGHT_FILL 0    // all LEDs in color arg
+#define LIGHT_DOT 1     // LED arg in COLOR_DOT, all others off
+#define LIGHT_RAINBOW 2 // rainbow, starting at entry arg
+
+// The light shows only draw into the frame buffer (palette index per LED).
+// frame_send() transfers it once per frame, if it changed.
+uint8_t frame_buf[WS2812B_FB4_SIZE(NUM_LED)];
+uint8_t frame_dirty = 0;
+uint32_t last_frame_time = 0;
+
+void light_action(uint8_t action, uint8_t arg)
+{
+    switch (action)
     {
+    case LIGHT_FILL:
         for (uint8_t i = 0; i < NUM_LED; i++)
         {
-            ws2812b_bang_byte(PB3, 0);
-            ws2812b_bang_byte(PB3, 0);
-            ws2812b_bang_byte(PB3, 0);
+            ws2812b_fb4_set(frame_buf, i, arg);
         }
-        return CHOREO_IDLE;
-    }
-
-    // Increment step by time
-    uint8_t step = (uint8_t)(time >> 8);
-    if (step == step_old)
-    {
-        return step;
-    }
-
-    // Handle step increment
-    switch (step)
-    {
-    case 0:
+        break;
+    case LIGHT_DOT:
         for (uint8_t i = 0; i < NUM_LED; i++)
         {
-            ws2812b_bang_byte(PB3, 0);
-            ws2812b_bang_byte(PB3, 255);
-            ws2812b_bang_byte(PB3, 0);
+            ws2812b_fb4_set(frame_buf, i, (i == arg) ? COLOR_DOT : COLOR_OFF);
         }
-        return step;
-    case 1:
+        break;
+    case LIGHT_RAINBOW:
         for (uint8_t i = 0; i < NUM_LED; i++)
         {
-            ws2812b_bang_byte(PB3, 0);
-            ws2812b_bang_byte(PB3, 0);
-            ws2812b_bang_byte(PB3, 0);
+            ws2812b_fb4_set(frame_buf, i, flash_u8(&rainbow[arg]));
+            arg = (arg + 1 < LEN_RAINBOW) ? arg + 1 : 0;
         }
-        return step;
-    case 2:
-    default:
-        return CHOREO_IDLE; // finish choreo
+        break;
     }
+    frame_dirty = 1;
 }
 
-uint8_t choreo_func_start_light(uint8_t step_old, uint32_t time, const void *data)
+// Sends the frame buffer, if it changed and the last frame is at least
+// FRAME_INTERVAL ms ago (force: right away). Transfers are always at least
+// one latch apart, so they are never read as one frame.
+void frame_send(uint8_t force)
 {
-    // Reset requested: Go to idle state
-    if (step_old == CHOREO_RESET)
+    if (!frame_dirty || (!force && timemeas_now() - last_frame_time < FRAME_INTERVAL))
     {
-        for (uint8_t i = 0; i < NUM_LED; i++)
-        {
-            ws2812b_bang_byte(PB3, 0);
-            ws2812b_bang_byte(PB3, 0);
-            ws2812b_bang_byte(PB3, 0);
-        }
-        return CHOREO_IDLE;
+        return;
     }
 
-    // Increment step by time
-    // this will loop the choreo forever (% NUM_LED)
-    uint8_t step = (uint8_t)(time >> 6) % NUM_LED;
-    if (step == step_old)
-    {
-        return step;
-    }
+    // Bit-Banging. Palette lookup (SRAM) happens while sending
+    ws2812b_send_fb4_ram(PB3, frame_buf, NUM_LED, palette_out);
+    frame_dirty = 0;
+    last_frame_time = timemeas_now();
+}
+
+// Light shows, written for NUM_LED = 10
+
+// Dot running from the last to the first LED, 64ms per LED
+const choreo_keyframe show_start[] FLASH = {
+    CHOREO_KF_ON_STOP(LIGHT_FILL, COLOR_OFF),
+    {0, LIGHT_DOT, 9},
+    {64, LIGHT_DOT, 8},
+    {128, LIGHT_DOT, 7},
+    {192, LIGHT_DOT, 6},
+    {256, LIGHT_DOT, 5},
+    {320, LIGHT_DOT, 4},
+    {384, LIGHT_DOT, 3},
+    {448, LIGHT_DOT, 2},
+    {512, LIGHT_DOT, 1},
+    {576, LIGHT_DOT, 0},
+    {640, CHOREO_KF_END, 0},
+};
 
-    uint8_t pos = NUM_LED - 1 - step;
+// Red flashing
+const choreo_keyframe show_lost[] FLASH = {
+    CHOREO_KF_ON_STOP(LIGHT_FILL, COLOR_OFF),
+    {0, LIGHT_FILL, COLOR_LOST},
+    {256, LIGHT_FILL, COLOR_OFF},
+    {512, CHOREO_KF_END, 0},
+};
 
-    // Bit-Banging. No fancy calculations in this loop!
-    for (uint8_t i = 0; i < NUM_LED; i++)
-    {
-        if (i == pos)
-        {
-            ws2812b_bang_byte(PB3, 0);
-            ws2812b_bang_byte(PB3, 255);
-            ws2812b_bang_byte(PB3, 255);
-        }
-        else
-        {
-            ws2812b_bang_byte(PB3, 0);
-            ws2812b_bang_byte(PB3, 0);
-            ws2812b_bang_byte(PB3, 0);
-        }
-    }
+// Rotating rainbow, 128ms per LED
+const choreo_keyframe show_success[] FLASH = {
+    CHOREO_KF_ON_STOP(LIGHT_FILL, COLOR_OFF),
+    {0, LIGHT_RAINBOW, 0},
+    {128, LIGHT_RAINBOW, 1},
+    {256, LIGHT_RAINBOW, 2},
+    {384, LIGHT_RAINBOW, 3},
+    {512, LIGHT_RAINBOW, 4},
+    {640, LIGHT_RAINBOW, 5},
+    {768, LIGHT_RAINBOW, 6},
+    {896, LIGHT_RAINBOW, 7},
+    {1024, LIGHT_RAINBOW, 8},
+    {1152, LIGHT_RAINBOW, 9},
+    {1280, CHOREO_KF_END, 0},
+};
 
-    return step;
+// Plays the light show passed as data
+uint8_t choreo_func_light(uint8_t step_old, uint32_t time, const void *data)
+{
+    return choreo_kf_play(step_old, time, (const choreo_keyframe *)data, light_action);
 }
 
-uint8_t choreo_func_success_light(uint8_t step_old, uint32_t time, const void *data)
+// Timer1 (buzzer PWM) only runs while a melody plays, it is powered off
+// otherwise (see zzz_power_off()). PB1 is disconnected from Timer1 then
+void buzzer_power(uint8_t on)
 {
-    const uint8_t palette[][3] = {
-        {63, 0, 0},  // Green
-        {63, 63, 0}, // Yellow
-        {25, 63, 0}, // Orange
-        {0, 63, 0},  // Red
-        {0, 22, 22}, // Pink
-        {16, 0, 39}  // Blue
-    };
-
-    const uint8_t sequence[] = {0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5};
-    const uint8_t len_sequence = 12;
-
-    // Reset requested: Go to idle state
-    if (step_old == CHOREO_RESET)
+    if (on)
     {
-        for (uint8_t i = 0; i < NUM_LED; i++)
-        {
-            ws2812b_bang_byte(PB3, 0);
-            ws2812b_bang_byte(PB3, 0);
-            ws2812b_bang_byte(PB3, 0);
-        }
-        return CHOREO_IDLE;
+        zzz_power_on(1 << PRTIM1);
+        TCCR1 |= (1 << COM1A1);
     }
-
-    // Increment step by time
-    // this will loop the choreo forever (% NUM_LED)
-    uint8_t step = (uint8_t)(time >> 7) % NUM_LED;
-    if (step == step_old)
+    else
     {
-        return step;
-    }
-
-    uint8_t sequence0 = step % len_sequence;
-
-    // Bit-Banging. No fancy calculations in this loop!
-    for (uint8_t i = 0; i < NUM_LED; i++)
-    {
-        uint8_t seq = sequence[(sequence0 + i) % len_sequence];
-        ws2812b_bang_byte(PB3, palette[seq][0]);
-        ws2812b_bang_byte(PB3, palette[seq][1]);
-        ws2812b_bang_byte(PB3, palette[seq][2]);
+        OCR1A = 0;
+        OCR1C = 0;
+        TCCR1 &= ~(1 << COM1A1);
+        zzz_power_off(1 << PRTIM1);
     }
-
-    return step;
 }
 
 uint8_t choreo_func_melody(uint8_t step_old, uint32_t time, const void *data)
 {
-    // Assuming data points to a melody array
-    const cnote_t *melody = data;
+    // Assuming data points to a (non-const) melody player
+    melody_player *player = (melody_player *)data;
+    const cnote_t *melody = player->melody;
 
     // Reset requested: Go to idle state
     if (step_old == CHOREO_RESET)
     {
-        OCR1A = 0;
-        OCR1C = 0;
+        buzzer_power(0);
         return CHOREO_IDLE;
     }
 
-    // Calculate step based on elapsed time and accumulated time of melody notes
-    uint32_t accumulated_time = 0;
-    uint8_t current_step = 0;
+    // The step is the cursor (index of the current note)
+    uint8_t step = step_old;
 
-    for (;;)
+    if (step_old == CHOREO_IDLE)
     {
-        const cnote_t *note = &melody[current_step];
-
-        if (note->ctr_top == 0xff)
-        {
-            OCR1A = 0;
-            OCR1C = 0;
-            return CHOREO_IDLE;
-        }
-
-        if (time < accumulated_time + note->duration)
-        {
-            break;
-        }
+        buzzer_power(1);
+        step = 0;
+        player->note_end = flash_u16(&melody[0].duration);
+    }
 
-        accumulated_time += note->duration;
-        current_step++;
+    // Advance the cursor past all notes that have ended.
+    // Usually none or one per tick, independent of melody length and elapsed time
+    uint8_t ctr_top = flash_u8(&melody[step].ctr_top);
+    while (ctr_top != 0xff && time >= player->note_end)
+    {
+        step++;
+        ctr_top = flash_u8(&melody[step].ctr_top);
+        player->note_end += flash_u16(&melody[step].duration);
     }
 
-    if (current_step != step_old)
+    if (ctr_top == 0xff)
     {
-        const cnote_t *note = &melody[current_step];
+        buzzer_power(0);
+        return CHOREO_IDLE;
+    }
+
+    choreo_wake_at(player->note_end);
 
+    if (step != step_old)
+    {
         // ToDo: this might not lead to the actual frequency
-        OCR1C = note->ctr_top;
-        OCR1A = note->ctr_top >> 1; // to from HI to LOW half way counting up -> 50% duty cycle -> square wave
+        OCR1C = ctr_top;
+        OCR1A = ctr_top >> 1; // to from HI to LOW half way counting up -> 50% duty cycle -> square wave
     }
 
-    return current_step;
+    return step;
 }
 
-choreo choreo_light_start;
-choreo choreo_light_lost;
-choreo choreo_light_success;
-choreo choreo_melody_start;
-choreo choreo_melody_lost;
-choreo choreo_melody_success;
+// All choreos, dispatched statically (see choreo_static.h).
+// The light shows loop, the melodies are performed once
+#define CHOREO_LIST(X)                                    \
+    X(light_start, choreo_func_light, 1, show_start)      \
+    X(light_lost, choreo_func_light, 1, show_lost)        \
+    X(light_success, choreo_func_light, 1, show_success)  \
+    X(melody_start, choreo_func_melody, 0, &player_start) \
+    X(melody_lost, choreo_func_melody, 0, &player_lost)   \
+    X(melody_success, choreo_func_melody, 0, &player_success)
+#include "../choreo_static.h"
 
-void tick_all_choreos(void)
+void stop_all_choreos(void)
 {
-    // ToDo: move the step != CHOREO_IDLE check into choreo_tick()?
-    // ToDo: rename CHOREO_IDLE to CHOREO_STOPPED?
-    if (choreo_light_start.step != CHOREO_IDLE)
-    {
-        choreo_tick(&choreo_light_start);
-    }
-
-    if (choreo_light_lost.step != CHOREO_IDLE)
-    {
-        choreo_tick(&choreo_light_lost);
-    }
-
-    if (choreo_light_success.step != CHOREO_IDLE)
-    {
-        choreo_tick(&choreo_light_success);
-    }
+    // Only running choreos are stopped.
+    // Their lights are cleared in the frame buffer, not sent
+    choreo_static_stop_all();
+}
 
-    if (choreo_melody_start.step != CHOREO_IDLE)
-    {
-        choreo_tick(&choreo_melody_start);
-    }
+#ifdef TELEMETRY
+// Sends a telemetry frame every TELEMETRY_INTERVAL ms, if the buzzer is silent
+void send_telemetry(void)
+{
+    static uint32_t last_send_time = 0;
+    uint32_t now = timemeas_now();
 
-    if (choreo_melody_lost.step != CHOREO_IDLE)
+    if (now - last_send_time < TELEMETRY_INTERVAL ||
+        choreo_static_step(CHOREO_ID(melody_start)) != CHOREO_IDLE ||
+        choreo_static_step(CHOREO_ID(melody_lost)) != CHOREO_IDLE ||
+        choreo_static_step(CHOREO_ID(melody_success)) != CHOREO_IDLE)
     {
-        choreo_tick(&choreo_melody_lost);
+        return;
     }
 
-    if (choreo_melody_success.step != CHOREO_IDLE)
-    {
-        choreo_tick(&choreo_melody_success);
-    }
-}
+    // PB1 is disconnected from Timer1 while no melody plays, see
+    // buzzer_power(). No melody can start while the frame is sent
+    telemetry_zzz_stats(TELEMETRY_ZZZ);
+    PORTB |= (1 << PB1);
+    _delay_us(TELEMETRY_IDLE_US);
+    telemetry_send(PB1, TELEMETRY_SOURCE, (uint16_t)(now - last_send_time));
+    PORTB &= ~(1 << PB1);
 
-void stop_all_choreos(void)
-{
-    // ToDo: change choreo_stop() to only call the choreo function with CHOREO_RESET if it is not stopped already
-    choreo_stop(&choreo_light_start);
-    _delay_ms(2);
-    choreo_stop(&choreo_light_lost);
-    _delay_ms(2);
-    choreo_stop(&choreo_light_success);
-    _delay_ms(2);
-    choreo_stop(&choreo_melody_start);
-    _delay_ms(2);
-    choreo_stop(&choreo_melody_lost);
-    _delay_ms(2);
-    choreo_stop(&choreo_melody_success);
-    _delay_ms(2);
+    last_send_time = now;
 }
-
-// Empty ISR for the pin change interrupt
-ISR(PCINT0_vect) {}
+#endif
 
 int main(void)
 {
@@ -347,14 +376,23 @@ int main(void)
     // Pull-up for inputs
     PORTB |= (1 << DDB0) | (1 << DDB2) | (1 << DDB4);
 
-    // Enable PWM for Buzzer
-    // Counter/Timer1 PWM Mode and Prescaler /1024
-    TCCR1 |= (1 << PWM1A) | (1 << COM1A1) | (1 << CS13) | (1 << CS11) | (1 << CS10);
+    // Telemetry UART on PB1, kept LOW between frames, see send_telemetry()
+    telemetry_init(PB1);
+    PORTB &= ~(1 << PB1);
+
+    // Configure PWM for Buzzer
+    // Counter/Timer1 PWM Mode and Prescaler /1024.
+    // PB1 is connected while a melody plays, see buzzer_power()
+    TCCR1 |= (1 << PWM1A) | (1 << CS13) | (1 << CS11) | (1 << CS10);
+
+    // Power off unused peripherals, and Timer1 until a melody plays
+    zzz_power_off((1 << PRADC) | (1 << PRUSI) | (1 << PRTIM1));
 
     cli();
 
-    // Set Pin Change Interrupt Enable (PCIE)
-    GIMSK |= (1 << PCIE); // General Interrupt Mask Register (GIMSK)
+    // Set Pin Change Interrupt Enable (PCIE).
+    // PCINT0_vect is defined by pinlatch
+    pinlatch_init();
 
     // Set mask bit for pin PB2 to activate interrupt if PB2 changes
     PCMSK |= (1 << PCINT2); // Pin Change Mask Register (PCMSK)
@@ -363,13 +401,8 @@ int main(void)
     timemeas_init();
     sei();
 
-    // Initialize choreos
-    choreo_init(&choreo_light_start, 1, 0, choreo_func_start_light);
-    choreo_init(&choreo_light_lost, 1, 0, choreo_func_lost_light);
-    choreo_init(&choreo_light_success, 0, 0, choreo_func_success_light);
-    choreo_init(&choreo_melody_start, 0, melody_start, choreo_func_melody);
-    choreo_init(&choreo_melody_lost, 0, melody_lost, choreo_func_melody);
-    choreo_init(&choreo_melody_success, 0, melody_success, choreo_func_melody);
+    // Output colors, computed once
+    gamma_palette(palette, palette_out, NUM_COLORS, LED_BRIGHTNESS);
 
     // Time on which the last input occured.
     // Used to go into sleep mode if no one is playing
@@ -377,7 +410,19 @@ int main(void)
 
     while (1)
     {
-        tick_all_choreos();
+        SIM_LOOP_MARK();
+
+#ifdef TELEMETRY
+        uint32_t loop_start_us = timemeas_now_us();
+        telemetry_count(TELEMETRY_LOOPS);
+#endif
+
+        // Only ticks the running choreos that are due
+        choreo_static_tick();
+
+#ifdef TELEMETRY
+        telemetry_hist(TELEMETRY_TICK_US, (uint16_t)(timemeas_now_us() - loop_start_us));
+#endif
 
         // State Machine
         switch (state)
@@ -389,42 +434,79 @@ int main(void)
             if ((PINB & (1 << PINB2)) == 0) // Hit start pad
             {
                 stop_all_choreos();
-                choreo_start(&choreo_light_start);
-                choreo_start(&choreo_melody_start);
+                choreo_static_start(CHOREO_ID(light_start));
+                choreo_static_start(CHOREO_ID(melody_start));
                 state = STATE_PLAYING;
                 last_input_time = timemeas_now();
+                telemetry_count(TELEMETRY_GAMES);
+                // Brief hits are latched, even while the loop is busy
+                pinlatch_arm(HIT_PINS);
             }
             break;
         case STATE_PLAYING:
-            if ((PINB & (1 << PINB0)) == 0) // Hit wire
+        {
+            uint32_t wire_time;
+            uint32_t goal_time;
+            uint8_t wire_hit = pinlatch_take(PB0, &wire_time);
+            uint8_t goal_hit = pinlatch_take(PB4, &goal_time);
+
+            // Both latched since the last pass: the earlier hit counts
+            if (wire_hit && goal_hit)
+            {
+                if ((int32_t)(goal_time - wire_time) < 0)
+                {
+                    wire_hit = 0;
+                }
+                else
+                {
+                    goal_hit = 0;
+                }
+            }
+
+            if (wire_hit) // Hit wire
             {
+                pinlatch_disarm(HIT_PINS);
                 stop_all_choreos();
-                choreo_start(&choreo_light_lost);
-                choreo_start(&choreo_melody_lost);
+                choreo_static_start(CHOREO_ID(light_lost));
+                choreo_static_start(CHOREO_ID(melody_lost));
                 state = STATE_LOST;
-                last_input_time = timemeas_now();
+                last_input_time = wire_time;
             }
-            if ((PINB & (1 << PINB4)) == 0) // Hit goal pad
+            else if (goal_hit) // Hit goal pad
             {
+                pinlatch_disarm(HIT_PINS);
                 stop_all_choreos();
-                choreo_start(&choreo_light_success);
-                choreo_start(&choreo_melody_success);
+                choreo_static_start(CHOREO_ID(light_success));
+                choreo_static_start(CHOREO_ID(melody_success));
                 state = STATE_WON;
-                last_input_time = timemeas_now();
+                last_input_time = goal_time;
             }
             break;
         }
+        }
+
+        // At most one LED transfer per frame, for all changes of this pass
+        frame_send(0);
 
         // Go to sleep if no one is playing
         if (timemeas_now() - last_input_time > TIME_UNTIL_SLEEP)
         {
+            // Only the start pad wakes up
+            pinlatch_disarm(HIT_PINS);
             stop_all_choreos();
-            // This delay prevents additional Pin Change Interrupts
-            // (due to button bouncing/release) canceling the sleep
-            _delay_ms(500);
-            zzz_sleep();
+            // LEDs off
+            frame_send(1);
+            // Wakes up on the next press, bouncing and releasing the start
+            // pad go back to sleep
+            zzz_sleep_pressed(1 << PB2);
             state = STATE_IDLE;
             last_input_time = timemeas_now();
+            telemetry_count(TELEMETRY_WAKEUPS);
         }
+
+#ifdef TELEMETRY
+        telemetry_hist(TELEMETRY_LOOP_US, (uint16_t)(timemeas_now_us() - loop_start_us));
+        send_telemetry();
+#endif
     }
 }
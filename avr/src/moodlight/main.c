@@ -22,40 +22,77 @@ SOFTWARE.
 #include <stdint.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
-#include <util/delay.h>
 #include "../ws2812b.h"
 #include "../zzz.h"
 #include "../timemeas.h"
 #include "../debounce.h"
+#include "../flash.h"
+#include "../gamma.h"
+#include "../adc.h"
+#include "../telemetry.h"
+#include "../simbench.h"
 
 #define NUM_LED 24
 #define TIME_TO_SLEEP 300000
-
+#define LED_BRIGHTNESS 135 // 0..255, see gamma.h
+
+// While asleep, the first LED breathes once every BREATHE_INTERVAL ms
+// (power-down in between, timed by the WDT, see zzz.h). 0: stay dark
+#define BREATHE_INTERVAL 4000
+#define BREATHE_COLOR 5 // palette index
+#define BREATHE_LEVEL 48 // max. brightness, 0..255
+#define BREATHE_STEPS 32 // steps up and down
+#define BREATHE_STEP_MS 16
+
+// Ambient light (make AMBIENT=1): light sensor on PB3 (ADC3), e.g. an LDR
+// to VCC and 10k to GND. The brighter the room, the brighter the LEDs
+#define AMBIENT_ADMUX ((1 << MUX1) | (1 << MUX0)) // ADC3, VCC as reference
+#define BRIGHTNESS_MIN 24 // in the dark, 0..255
+#define BRIGHTNESS_HYST 8 // change to convert the palette again
+
+// Up to this number of LEDs, a frame is rendered into a buffer and then sent.
+// Longer strips are rendered pixel by pixel while sending (no buffer)
+#define FRAME_BUF_MAX_LED 64
+
+// Telemetry (make TELEMETRY=1) on PB4, see telemetry.h
+#define TELEMETRY_SOURCE 2
+#define TELEMETRY_INTERVAL 1000 // [ms]
+#define TELEMETRY_LOOPS 0       // counter: main loop passes
+#define TELEMETRY_FRAMES 1      // counter: frames sent
+#define TELEMETRY_MODES 2       // counter: mode switches
+#define TELEMETRY_WAKEUPS 3     // counter: wake-ups from sleep
+#define TELEMETRY_ZZZ 4         // counters 4..7: time [ms] per sleep state (make ZZZ_STATS=1)
+#define TELEMETRY_FRAME_US 0    // histogram: frame send time
+#define TELEMETRY_PERIOD_US 1   // histogram: time between frames
+
+// All tables below are stored in flash, see flash.h
 typedef struct
 {
-    uint8_t *seq;
+    const uint8_t *seq; // FLASH
     uint8_t seq_len;
     uint8_t time_shift;
 } mode;
 
-const uint8_t palette[][3] = {
-    {63, 0, 0},  // Green
-    {63, 63, 0}, // Yellow
-    {25, 63, 0}, // Orange
-    {0, 63, 0},  // Red
-    {0, 22, 22}, // Pink
-    {16, 0, 39}, // Blue
-    {6, 17, 36}, // Purple
-    {22, 0, 22}  // Turquoise
+// Full range, output at LED_BRIGHTNESS with gamma correction (palette_out, see gamma.h)
+const uint8_t palette[][3] FLASH = {
+    {255, 0, 0},    // Green
+    {255, 255, 0},  // Yellow
+    {168, 255, 0},  // Orange
+    {0, 255, 0},    // Red
+    {0, 158, 158},  // Pink
+    {137, 0, 205},  // Blue
+    {88, 141, 198}, // Purple
+    {158, 0, 158}   // Turquoise
 };
+#define NUM_COLORS (sizeof(palette) / sizeof(palette[0]))
 
-uint8_t sequence_0[] = {0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5};
-uint8_t sequence_1[] = {6, 6, 7, 7};
-uint8_t sequence_2[] = {6, 6, 1, 1, 7, 7};
-uint8_t sequence_3[] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4};
-uint8_t sequence_4[] = {3, 3, 3, 3, 3, 3, 6, 6, 6, 6, 6, 6};
+const uint8_t sequence_0[] FLASH = {0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5};
+const uint8_t sequence_1[] FLASH = {6, 6, 7, 7};
+const uint8_t sequence_2[] FLASH = {6, 6, 1, 1, 7, 7};
+const uint8_t sequence_3[] FLASH = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4};
+const uint8_t sequence_4[] FLASH = {3, 3, 3, 3, 3, 3, 6, 6, 6, 6, 6, 6};
 
-const mode modes[] = {
+const mode modes[] FLASH = {
     {sequence_0, 12, 7},
     {sequence_2, 6, 9},
     {sequence_1, 4, 9},
@@ -64,16 +101,171 @@ const mode modes[] = {
 
 const uint8_t num_modes = sizeof(modes) / sizeof(modes[0]);
 
+// palette at LED_BRIGHTNESS, gamma corrected. Frames are rendered from it
+uint8_t palette_out[NUM_COLORS][3];
+
+// Position in the sequence of the current mode, for rendering pixel by pixel
+typedef struct
+{
+    const uint8_t *seq; // FLASH
+    uint8_t seq_len;
+    uint8_t seq_idx;
+} sequence_cursor;
+
+// Pixel generator (ws2812b_pixel_gen): color of the next sequence entry
+void sequence_pixel(uint8_t *grb, void *ctx)
+{
+    sequence_cursor *cursor = ctx;
+    const uint8_t *color = palette_out[flash_u8(&cursor->seq[cursor->seq_idx])];
+
+    grb[0] = color[0];
+    grb[1] = color[1];
+    grb[2] = color[2];
+
+    if (++cursor->seq_idx == cursor->seq_len)
+    {
+        cursor->seq_idx = 0;
+    }
+}
+
+// Pixel generator (ws2812b_pixel_gen): off
+void black_pixel(uint8_t *grb, void *ctx)
+{
+    grb[0] = 0;
+    grb[1] = 0;
+    grb[2] = 0;
+}
+
+#if NUM_LED <= FRAME_BUF_MAX_LED
+// GRB bytes of all LEDs, sent with one ws2812b_send_frame()
+uint8_t frame_buf[NUM_LED * 3];
+#endif
+
 ISR(PCINT0_vect) {}
 
-void prepare_sleep(void)
+// Prepares frame (number) of mode mode_idx: renders it into frame_buf, or
+// sets up cursor to render it while sending
+void frame_prepare(sequence_cursor *cursor, uint8_t mode_idx, uint32_t frame)
 {
+    // Read the mode from flash once per frame,
+    // the first LED shows sequence entry (frame % seq_len)
+    cursor->seq = flash_ptr(&modes[mode_idx].seq);
+    cursor->seq_len = flash_u8(&modes[mode_idx].seq_len);
+    cursor->seq_idx = (uint8_t)(frame) % cursor->seq_len;
+
+#if NUM_LED <= FRAME_BUF_MAX_LED
     for (uint8_t i = 0; i < NUM_LED; i++)
     {
-        ws2812b_bang_byte(PB1, 0);
-        ws2812b_bang_byte(PB1, 0);
-        ws2812b_bang_byte(PB1, 0);
+        sequence_pixel(&frame_buf[i * 3], cursor);
     }
+#endif
+}
+
+// Sends the prepared frame
+void frame_send(sequence_cursor *cursor)
+{
+#if NUM_LED <= FRAME_BUF_MAX_LED
+    // Only streams the bytes, all lookups are done
+    ws2812b_send_frame(PB1, frame_buf, sizeof(frame_buf));
+#else
+    // Update LEDs, rendering while sending
+    ws2812b_send_stream(PB1, NUM_LED, sequence_pixel, cursor);
+#endif
+}
+
+#ifdef AMBIENT_LIGHT
+// Returns the LED brightness for an ambient light value (see adc.h):
+// BRIGHTNESS_MIN in the dark, up to 255
+uint8_t ambient_brightness(uint16_t ambient)
+{
+    // Upper 8 of 10 + ADC_OVERSAMPLE bits
+    uint8_t level = ambient >> (2 + ADC_OVERSAMPLE);
+    return BRIGHTNESS_MIN + gamma_scale(level, 255 - BRIGHTNESS_MIN);
+}
+#endif
+
+void prepare_sleep(void)
+{
+    ws2812b_send_stream(PB1, NUM_LED, black_pixel, 0);
+}
+
+#if BREATHE_INTERVAL > 0
+// Pixel generator (ws2812b_pixel_gen): grb of ctx for the first LED, then off
+void breathe_pixel(uint8_t *grb, void *ctx)
+{
+    uint8_t *color = ctx;
+
+    grb[0] = color[0];
+    grb[1] = color[1];
+    grb[2] = color[2];
+
+    color[0] = 0;
+    color[1] = 0;
+    color[2] = 0;
+}
+
+// Fades the first LED up and down once.
+// Returns 0 if woken up by another interrupt (e.g. button), 1 otherwise
+uint8_t breathe(void)
+{
+    for (uint8_t i = 0; i <= BREATHE_STEPS; i++)
+    {
+        uint8_t level = (i < BREATHE_STEPS / 2 ? i : BREATHE_STEPS - i) * (BREATHE_LEVEL / (BREATHE_STEPS / 2));
+        uint8_t color[3];
+        color[0] = gamma_level(flash_u8(&palette[BREATHE_COLOR][0]), level);
+        color[1] = gamma_level(flash_u8(&palette[BREATHE_COLOR][1]), level);
+        color[2] = gamma_level(flash_u8(&palette[BREATHE_COLOR][2]), level);
+        ws2812b_send_stream(PB1, NUM_LED, breathe_pixel, color);
+
+        // Power-down between the steps, timed by the WDT
+        uint16_t slept;
+        uint8_t full = zzz_sleep_for(BREATHE_STEP_MS, &slept);
+        timemeas_advance(slept);
+        if (!full)
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+#endif
+
+// Sleeps until the button is pressed. Bouncing and releasing it go back to
+// sleep (see zzz_pins_pressed()). With BREATHE_INTERVAL, wakes up
+// periodically to breathe. The time slept is merged into timemeas
+void deep_sleep(void)
+{
+#if BREATHE_INTERVAL > 0
+    // Wait for a held press (e.g. the one that sent us to sleep) to be released
+    while (zzz_pins_pressed(1 << PB2))
+    {
+        zzz_sleep();
+    }
+
+    while (1)
+    {
+        uint16_t slept;
+        uint8_t full = zzz_sleep_for(BREATHE_INTERVAL, &slept);
+        timemeas_advance(slept);
+
+        if (full && breathe())
+        {
+            continue;
+        }
+
+        // Woken up by a pin change: only a settled press ends the sleep
+        if (zzz_pins_pressed(1 << PB2))
+        {
+            return;
+        }
+
+        // LEDs off, if the breath was interrupted
+        prepare_sleep();
+    }
+#else
+    zzz_sleep_pressed(1 << PB2);
+#endif
 }
 
 int main(void)
@@ -81,6 +273,9 @@ int main(void)
     // Initialize time measure
     timemeas_init();
 
+    // Power off unused peripherals. With AMBIENT_LIGHT, adc_init() powers on the ADC
+    zzz_power_off((1 << PRADC) | (1 << PRUSI) | (1 << PRTIM1));
+
     // Set direction of pins PB1 to out
     DDRB |= (1 << DDB1); // Port B data direction register (DDRB)
 
@@ -102,77 +297,149 @@ int main(void)
 
     sei();
 
-    // Initialize button debouncer with default values
-    debouncer button_deb;
-    debounce_init(&button_deb);
+    telemetry_init(PB4);
 
-    // Frame counter
-    uint32_t frame = 0;
-    uint32_t frame_last = 0xffffffff;
+    // Output colors, computed once (or on ambient light changes)
+    uint8_t brightness = LED_BRIGHTNESS;
+    gamma_palette(palette, palette_out, NUM_COLORS, brightness);
+
+#ifdef AMBIENT_LIGHT
+    // Sample the light sensor in the background, see adc.h
+    DIDR0 |= (1 << ADC3D); // No digital input on PB3
+    adc_init(AMBIENT_ADMUX);
+#endif
 
     // Mode State
     uint8_t current_mode_idx = 0;
+    uint8_t time_shift = flash_u8(&modes[0].time_shift);
+
+    // The next frame (number) is prepared ahead, and sent when it is due,
+    // at (frame_next << time_shift) ms
+    sequence_cursor cursor;
+    uint32_t frame_next = timemeas_now() >> time_shift;
+    frame_prepare(&cursor, current_mode_idx, frame_next);
 
     // Time of last input for auto-sleep
     uint32_t last_input_time = timemeas_now();
 
+#ifdef TELEMETRY
+    uint32_t last_send_time = timemeas_now();
+    uint32_t last_frame_us = timemeas_now_us();
+#endif
+
     while (1)
     {
+        SIM_LOOP_MARK();
+
+#ifdef TELEMETRY
+        telemetry_count(TELEMETRY_LOOPS);
+        if (timemeas_now() - last_send_time >= TELEMETRY_INTERVAL)
+        {
+            telemetry_zzz_stats(TELEMETRY_ZZZ);
+            telemetry_send(PB4, TELEMETRY_SOURCE, (uint16_t)(timemeas_now() - last_send_time));
+            last_send_time = timemeas_now();
+        }
+#endif
+
         // If moodlight runs for TIME_TO_SLEEP ms with no input, go to sleep
+        uint8_t mode_changed = 0;
         if ((timemeas_now() - last_input_time) > TIME_TO_SLEEP)
         {
             last_input_time = timemeas_now();
             current_mode_idx = 0;
+            mode_changed = 1;
 
             prepare_sleep();
-            // This delay prevents additional Pin Change Interrupts
-            // (due to button bouncing/release) canceling the sleep
-            _delay_ms(500);
-            zzz_sleep();
+            deep_sleep();
+            telemetry_count(TELEMETRY_WAKEUPS);
         }
 
-        // Calc frame from elapsed time
-        frame = (timemeas_now() >> modes[current_mode_idx].time_shift);
-
-        // Insert raw button state into the debouncer
-        debounce_update((PINB & (1 << PINB2)) ? 0 : 1, &button_deb);
+        // Collect button downs. The button is debounced in the Timer0 ISR
+        // (DEBOUNCE_ISR_PINS, see Makefile), so no press is lost while
+        // frames are sent
+        uint8_t pressed = 0;
+        debounce_event ev;
+        while (debounce_isr_pop(&ev))
+        {
+            pressed |= ev.pressed;
+        }
 
-        // Handle state change on button down
-        if (button_deb.state_changed && button_deb.state == 1)
+        // Handle button down
+        if (pressed & (1 << PB2))
         {
             last_input_time = timemeas_now();
 
             current_mode_idx = (current_mode_idx + 1) % num_modes;
+            mode_changed = 1;
+            telemetry_count(TELEMETRY_MODES);
 
             // If switched back to first mode, go to sleep
             if (current_mode_idx == 0)
             {
                 prepare_sleep();
-                // This delay prevents additional Pin Change Interrupts
-                // (due to button bouncing/release) canceling the sleep
-                _delay_ms(500);
-                zzz_sleep();
+                deep_sleep();
+                telemetry_count(TELEMETRY_WAKEUPS);
+                // The button press that woke us up is not a mode switch
+                debounce_isr_reset(1 << PB2);
             }
         }
-        else if (frame == frame_last)
+
+        // Show the new mode right away
+        if (mode_changed)
         {
-            continue;
+            time_shift = flash_u8(&modes[current_mode_idx].time_shift);
+            frame_next = timemeas_now() >> time_shift;
+            frame_prepare(&cursor, current_mode_idx, frame_next);
         }
 
-        // New frame
-        frame_last = frame;
+        // Idle until the next frame is due. Wakes up early for input events
+        uint32_t frame_time = frame_next << time_shift;
+        if ((int32_t)(timemeas_now() - frame_time) < 0)
+        {
+            timemeas_sleep_until(frame_time);
+            continue;
+        }
 
-        // Update LEDs
-        // Bit-Banging. No fancy calculations in this loop!
-        for (uint8_t i = 0; i < NUM_LED; i++)
+        // Late by a whole frame or more: prepare the current one instead
+        uint32_t frame = timemeas_now() >> time_shift;
+        if (frame != frame_next)
         {
-            uint8_t framei = ((uint8_t)(frame) + i) % modes[current_mode_idx].seq_len;
+            frame_next = frame;
+            frame_prepare(&cursor, current_mode_idx, frame_next);
+        }
 
-            ws2812b_bang_byte(PB1, palette[modes[current_mode_idx].seq[framei]][0]);
-            ws2812b_bang_byte(PB1, palette[modes[current_mode_idx].seq[framei]][1]);
-            ws2812b_bang_byte(PB1, palette[modes[current_mode_idx].seq[framei]][2]);
+#ifdef TELEMETRY
+        uint32_t frame_us = timemeas_now_us();
+        telemetry_hist(TELEMETRY_PERIOD_US, (uint16_t)(frame_us - last_frame_us));
+        last_frame_us = frame_us;
+#endif
+
+        frame_send(&cursor);
+
+#ifdef TELEMETRY
+        telemetry_count(TELEMETRY_FRAMES);
+        telemetry_hist(TELEMETRY_FRAME_US, (uint16_t)(timemeas_now_us() - frame_us));
+#endif
+
+#ifdef AMBIENT_LIGHT
+        // Follow the ambient light. Only the latest result is used: between
+        // the frames of slow modes (up to 512ms), more results are made than
+        // the queue of adc_pop() holds. The palette is only converted again
+        // (~0.3ms, see gamma.h) if the brightness changed noticeably
+        uint16_t ambient;
+        if (adc_read(&ambient)) // None before the first result
+        {
+            uint8_t level = ambient_brightness(ambient);
+            if (level >= brightness + BRIGHTNESS_HYST || level + BRIGHTNESS_HYST <= brightness)
+            {
+                brightness = level;
+                gamma_palette(palette, palette_out, NUM_COLORS, brightness);
+            }
         }
+#endif
 
-        _delay_ms(10);
+        // Prepare the next frame, while waiting for it to be due
+        frame_next++;
+        frame_prepare(&cursor, current_mode_idx, frame_next);
     }
 }
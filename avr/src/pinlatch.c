@@ -0,0 +1,104 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "timemeas.h"
+#include "pinlatch.h"
+
+volatile uint8_t pinlatch_armed = 0;
+volatile uint8_t pinlatch_latched = 0;
+uint32_t pinlatch_times[6]; // [ms] per PORTB pin, written by the ISR
+
+// Latches armed pins that are LOW now, called with interrupts disabled
+static void latch_low_pins(void)
+{
+    uint8_t low = ~PINB & pinlatch_armed & ~pinlatch_latched;
+    if (!low)
+    {
+        return;
+    }
+
+    uint32_t now = timemeas_now();
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        if (low & (1 << i))
+        {
+            pinlatch_times[i] = now;
+        }
+    }
+    pinlatch_latched |= low;
+}
+
+ISR(PCINT0_vect)
+{
+    latch_low_pins();
+}
+
+void pinlatch_init(void)
+{
+    pinlatch_armed = 0;
+    pinlatch_latched = 0;
+
+    // Set Pin Change Interrupt Enable (PCIE)
+    GIMSK |= (1 << PCIE); // General Interrupt Mask Register (GIMSK)
+}
+
+void pinlatch_arm(uint8_t pins)
+{
+    uint8_t sreg = SREG;
+    cli();
+    pinlatch_latched &= ~pins;
+    pinlatch_armed |= pins;
+    PCMSK |= pins; // PCINTn matches PBn
+    latch_low_pins();
+    SREG = sreg;
+}
+
+void pinlatch_disarm(uint8_t pins)
+{
+    uint8_t sreg = SREG;
+    cli();
+    pinlatch_armed &= ~pins;
+    pinlatch_latched &= ~pins;
+    PCMSK &= ~pins;
+    SREG = sreg;
+}
+
+uint8_t pinlatch_take(uint8_t pin, uint32_t *time)
+{
+    uint8_t ret = 0;
+
+    uint8_t sreg = SREG;
+    cli();
+    // Catches a LOW pin whose edge the ISR did not see (see pinlatch.h)
+    latch_low_pins();
+    if (pinlatch_latched & (1 << pin))
+    {
+        *time = pinlatch_times[pin];
+        pinlatch_latched &= ~(1 << pin);
+        ret = 1;
+    }
+    SREG = sreg;
+
+    return ret;
+}
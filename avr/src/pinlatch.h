@@ -0,0 +1,58 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef PINLATCH_H
+#define PINLATCH_H
+
+#include <stdint.h>
+
+// Latches falling edges (HIGH -> LOW, e.g. a contact to GND) of PORTB input
+// pins in the Pin Change Interrupt, with their time [ms] (timemeas_now()).
+// A brief contact is not missed, even if the main loop is busy, and the
+// main loop gets the time it actually happened:
+//   pinlatch_init();
+//   pinlatch_arm((1 << PB0) | (1 << PB4));
+//   uint32_t hit_time;
+//   if (pinlatch_take(PB0, &hit_time)) { ... }
+//   pinlatch_disarm((1 << PB0) | (1 << PB4));
+// This module defines PCINT0_vect. Pins in PCMSK that are not armed (e.g.
+// only used for waking up from sleep) are ignored by it.
+// Limit: the ISR reads PINB when it runs, not at the edge. A contact that is
+// already released by then is missed, so it must stay LOW longer than the
+// longest time interrupts are disabled, e.g. 12us per byte sent by ws2812b
+// (16us for APA106), plus the other ISRs. pinlatch_take() also latches armed
+// pins that are still LOW when it is called, with that time.
+// Requires timemeas.
+
+// Enables the Pin Change Interrupt (PCIE), nothing armed
+void pinlatch_init(void);
+
+// Clears and starts latching pins (mask). Armed pins already LOW are latched right away
+void pinlatch_arm(uint8_t pins);
+
+// Stops latching pins (mask) and clears them
+void pinlatch_disarm(uint8_t pins);
+
+// Returns 1 and the time [ms] of the first falling edge, if pin (e.g. PB0)
+// is latched or LOW now, and clears it. Returns 0 otherwise
+uint8_t pinlatch_take(uint8_t pin, uint32_t *time);
+
+#endif
@@ -20,6 +20,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 #include <avr/io.h>
+#include "../simbench.h"
 
 // Select PWM example below
 //  0: PWM on PB0 using Counter/Timer0 (488Hz, 25% duty cycle)
@@ -118,5 +119,7 @@ int main(void)
 
     while (1)
     {
+        SIM_LOOP_MARK();
+
     }
 }
@@ -24,6 +24,7 @@ SOFTWARE.
 #include <avr/interrupt.h>
 #include <util/delay.h>
 #include "../zzz.h"
+#include "../simbench.h"
 
 void setup(void);
 void loop(void);
@@ -73,6 +74,8 @@ int main(void)
     setup();
     while (1)
     {
+        SIM_LOOP_MARK();
+
         loop();
     }
 }
@@ -22,10 +22,10 @@ SOFTWARE.
 #include <stdint.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
-#include <util/delay.h>
 #include "../zzz.h"
 #include "../timemeas.h"
 #include "../debounce.h"
+#include "../simbench.h"
 
 #define STATE_SLOW 1
 #define STATE_FAST 2
@@ -44,6 +44,9 @@ int main(void)
     // Initialize time measure
     timemeas_init();
 
+    // Power off unused peripherals
+    zzz_power_off((1 << PRADC) | (1 << PRUSI) | (1 << PRTIM1));
+
     // Set direction of pin PB1 to out
     DDRB |= (1 << DDB1); // Port B data direction register (DDRB)
 
@@ -74,6 +77,8 @@ int main(void)
 
     while (1)
     {
+        SIM_LOOP_MARK();
+
         // Insert raw button state into the debouncer
         debounce_update((PINB & (1 << PINB2)) ? 0 : 1, &button_deb);
 
@@ -91,10 +96,9 @@ int main(void)
                 break;
             case STATE_PERMANENT:
                 PORTB &= ~(1 << PB1);
-                // This delay prevents additional Pin Change Interrupts
-                // (due to button bouncing/release) canceling the sleep
-                _delay_ms(500);
-                zzz_sleep();
+                // Wakes up on the next press, bouncing and releasing the
+                // button go back to sleep
+                zzz_sleep_pressed(1 << PB2);
                 // After wakeup, go to initial state
                 state = STATE_SLOW;
                 break;
@@ -102,6 +106,7 @@ int main(void)
         }
 
         // Perform state specific logic
+        uint32_t wakeTime = timemeas_now() + TOGGLE_DELAY_SLOW;
         switch (state)
         {
         case STATE_SLOW:
@@ -110,6 +115,7 @@ int main(void)
                 PORTB ^= (1 << PB1);
                 lastToggleTime = timemeas_now();
             }
+            wakeTime = lastToggleTime + TOGGLE_DELAY_SLOW + 1;
             break;
         case STATE_FAST:
             if (timemeas_now() - lastToggleTime > TOGGLE_DELAY_FAST)
@@ -117,7 +123,22 @@ int main(void)
                 PORTB ^= (1 << PB1);
                 lastToggleTime = timemeas_now();
             }
+            wakeTime = lastToggleTime + TOGGLE_DELAY_FAST + 1;
             break;
         }
+
+        // A button change, ignored by the debouncer so far, is taken over
+        // after its delay. No pin change may follow to wake us up.
+        uint8_t button = (PINB & (1 << PINB2)) ? 0 : 1;
+        uint32_t debounceTime = button_deb.last_change_time + button_deb.delay_time + 1;
+        if (button != button_deb.state && (int32_t)(debounceTime - wakeTime) < 0)
+        {
+            wakeTime = debounceTime;
+        }
+
+        // Sleep until the next deadline. A button change (Pin Change
+        // Interrupt) wakes us up earlier. With TIMEMEAS_TICKLESS (Makefile),
+        // Timer0 only interrupts a few times per sleep, instead of every 1ms.
+        timemeas_sleep_until(wakeTime);
     }
 }
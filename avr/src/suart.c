@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include <avr/io.h>
+#include <stdint.h>
+#include "suart.h"
+
+/*
+Cycles per bit (@ any F_CPU):
+
+  0  mov  port,lo
+  1  sbrc frame,0    (bit 0: 2 cycles, skipping the next mov)
+  2  mov  port,hi
+  3  out  port       (same cycle for both levels, no jitter)
+  4  lsr  frame hi
+  5  ror  frame lo
+  6  ldi  delay,N
+  7  dec  delay      \ 3 cycles per loop,
+     brne            / 2 for the last one
+     (0..2 nops)
+     dec  ctr
+     brne            (2 cycles)
+-> 9 + 3 * N (+ nops) cycles per bit
+
+@ 8MHz, 115200 baud: 69 cycles (N = 20) -> 115942 baud, +0.6%
+@ 1MHz, 19200 baud: 52 cycles (N = 14, 1 nop) -> 19231 baud, +0.2%
+*/
+#define SUART_DELAY_LOOPS ((SUART_CYCLES_PER_BIT - 9) / 3)
+#define SUART_EXTRA_CYCLES ((SUART_CYCLES_PER_BIT - 9) % 3)
+
+#if SUART_CYCLES_PER_BIT < 25
+#error SUART_BAUD is too high for F_CPU (> 2% error)
+#endif
+#if SUART_DELAY_LOOPS > 255
+#error SUART_BAUD is too low for F_CPU
+#endif
+
+void suart_init(const uint8_t portb_pin)
+{
+    PORTB |= (1 << portb_pin); // Idle HIGH
+    DDRB |= (1 << portb_pin);
+}
+
+void suart_send_byte(const uint8_t portb_pin, const uint8_t data)
+{
+    const uint8_t pb = PORTB;
+    const uint8_t pb_hi = (pb | (1 << portb_pin));
+    const uint8_t pb_lo = (pb & ~(1 << portb_pin));
+
+    // Bits to send, LSB first: start bit (LOW), 8 data bits, stop bit (HIGH)
+    uint16_t frame = ((uint16_t)data << 1) | 0x200;
+    uint8_t port;
+    uint8_t ctr;
+    uint8_t delay;
+    uint8_t sreg;
+
+    __asm__ volatile(
+        "in %[sreg],0x3f\n" // Save SREG (interrupt flag)
+        "ldi %[ctr],10\n"
+        "cli\n"
+
+        ".suart_bit%=:\n"
+        "mov %[port],%[pb_lo]\n"
+        "sbrc %A[frame],0\n"
+        "mov %[port],%[pb_hi]\n"
+        "out 0x18,%[port]\n" // Set bit level
+
+        // Prepare next bit
+        "lsr %B[frame]\n"
+        "ror %A[frame]\n"
+
+        // Wait for the rest of the bit time
+        "ldi %[delay],%[loops]\n"
+        ".suart_delay%=:\n"
+        "dec %[delay]\n"
+        "brne .suart_delay%=\n"
+#if SUART_EXTRA_CYCLES >= 1
+        "nop\n"
+#endif
+#if SUART_EXTRA_CYCLES >= 2
+        "nop\n"
+#endif
+
+        "dec %[ctr]\n"
+        "brne .suart_bit%=\n"
+
+        // Stop bit is on the line, it stays HIGH
+        "out 0x3f,%[sreg]\n"
+
+        : [frame] "+r"(frame), [port] "=&r"(port), [ctr] "=&d"(ctr), [delay] "=&d"(delay), [sreg] "=&r"(sreg) // Outputs
+        : [pb_hi] "r"(pb_hi), [pb_lo] "r"(pb_lo), [loops] "M"(SUART_DELAY_LOOPS)                           // Inputs
+        :);                                                                                                // Clobbered
+}
+
+void suart_send(const uint8_t portb_pin, const uint8_t *buf, uint8_t len)
+{
+    while (len--)
+    {
+        suart_send_byte(portb_pin, *buf++);
+    }
+}
@@ -0,0 +1,54 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef SUART_H
+#define SUART_H
+
+#include <stdint.h>
+
+// TX-only software UART (8N1, LSB first) on any PORTB pin, cycle-counted
+// like ws2812b.c. Interrupts are disabled while a byte is sent, pending
+// interrupts are served between bytes (line HIGH, stretching the stop bit).
+
+// Baud rate. The bit time is rounded to whole CPU cycles, the resulting
+// error is below 2%. Keep a byte (10 bits) below 1ms, so that no timemeas
+// tick (Timer0 compare match) gets lost while interrupts are disabled.
+#ifndef SUART_BAUD
+#if F_CPU == 8000000
+#define SUART_BAUD 115200
+#else
+#define SUART_BAUD 19200
+#endif
+#endif
+
+// CPU cycles per bit
+#define SUART_CYCLES_PER_BIT ((F_CPU + SUART_BAUD / 2) / SUART_BAUD)
+
+// Sets the pin to output, HIGH (idle)
+void suart_init(const uint8_t portb_pin);
+
+// Sends a single byte
+void suart_send_byte(const uint8_t portb_pin, const uint8_t data);
+
+// Sends len bytes from buf
+void suart_send(const uint8_t portb_pin, const uint8_t *buf, uint8_t len);
+
+#endif
@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifdef TELEMETRY
+
+#include <stdint.h>
+#include <util/crc16.h>
+#include "suart.h"
+#include "telemetry.h"
+
+#ifdef ZZZ_STATS
+#include "zzz.h"
+#endif
+
+uint16_t telemetry_counters[TELEMETRY_NUM_COUNTERS];
+uint16_t telemetry_bins[TELEMETRY_NUM_HISTS][TELEMETRY_HIST_BINS];
+uint8_t telemetry_seq = 0;
+
+void telemetry_init(const uint8_t portb_pin)
+{
+    suart_init(portb_pin);
+}
+
+void telemetry_count(uint8_t idx)
+{
+    telemetry_counters[idx]++;
+}
+
+void telemetry_add(uint8_t idx, uint16_t n)
+{
+    telemetry_counters[idx] += n;
+}
+
+#ifdef ZZZ_STATS
+void telemetry_zzz_stats(uint8_t idx)
+{
+    static uint32_t last_ms[ZZZ_NUM_STATES];
+    zzz_stats now_stats;
+
+    zzz_stats_get(&now_stats);
+    for (uint8_t s = 0; s < ZZZ_NUM_STATES; s++)
+    {
+        telemetry_counters[idx + s] += (uint16_t)(now_stats.ms[s] - last_ms[s]);
+        last_ms[s] = now_stats.ms[s];
+    }
+}
+#endif
+
+void telemetry_hist(uint8_t idx, uint16_t value)
+{
+    value >>= TELEMETRY_HIST_SHIFT;
+
+    // Bin: number of significant bits (log2 + 1), no loop over all bins
+    uint8_t bin = 0;
+    while (value && bin < (TELEMETRY_HIST_BINS - 1))
+    {
+        value >>= 1;
+        bin++;
+    }
+
+    telemetry_bins[idx][bin]++;
+}
+
+// Sends a byte, updating the CRC
+static uint8_t send_byte(const uint8_t portb_pin, uint8_t crc, uint8_t data)
+{
+    suart_send_byte(portb_pin, data);
+    return _crc8_ccitt_update(crc, data);
+}
+
+// Sends uint16 values (little endian) and clears them, updating the CRC
+static uint8_t send_values(const uint8_t portb_pin, uint8_t crc, uint16_t *values, uint8_t num)
+{
+    for (uint8_t i = 0; i < num; i++)
+    {
+        crc = send_byte(portb_pin, crc, (uint8_t)values[i]);
+        crc = send_byte(portb_pin, crc, (uint8_t)(values[i] >> 8));
+        values[i] = 0;
+    }
+    return crc;
+}
+
+void telemetry_send(const uint8_t portb_pin, uint8_t source, uint16_t interval)
+{
+    uint8_t crc = 0;
+
+    crc = send_byte(portb_pin, crc, 0x55);
+    crc = send_byte(portb_pin, crc, 0xaa);
+    crc = send_byte(portb_pin, crc, source);
+    crc = send_byte(portb_pin, crc, telemetry_seq++);
+    crc = send_byte(portb_pin, crc, TELEMETRY_NUM_COUNTERS);
+    crc = send_byte(portb_pin, crc, TELEMETRY_NUM_HISTS);
+    crc = send_byte(portb_pin, crc, TELEMETRY_HIST_BINS);
+    crc = send_values(portb_pin, crc, &interval, 1);
+    crc = send_values(portb_pin, crc, telemetry_counters, TELEMETRY_NUM_COUNTERS);
+    crc = send_values(portb_pin, crc, &telemetry_bins[0][0], TELEMETRY_NUM_HISTS * TELEMETRY_HIST_BINS);
+
+    suart_send_byte(portb_pin, crc);
+}
+
+#endif
@@ -0,0 +1,108 @@
+/*
+Copyright (c) 2023-2025 Alexander Scholz
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+// Profiling counters and histograms, sent as binary frames via suart.
+// Decode them on the PC with telemetry_pc.py.
+//
+// Only active if TELEMETRY is defined (e.g. make TELEMETRY=1, see the
+// hot_wire Makefile). Otherwise, all calls compile to nothing, so they can
+// stay in the code.
+//
+// Usage (main loop only, not from ISRs):
+//   telemetry_init(PB4);
+//   telemetry_count(0);               // counter 0 += 1
+//   telemetry_hist(0, t1 - t0);       // histogram 0, e.g. a duration [us]
+//   telemetry_send(PB4, 2, interval); // send a frame, clear all values
+//
+// Frame (little endian):
+//   0x55 0xaa                  sync
+//   source, seq                example id, frame counter
+//   counters, hists, bins      numbers of values, see below
+//   interval                   uint16, time [ms] covered by the frame
+//   counter[counters]          uint16 each
+//   bin[hists][bins]           uint16 each
+//   crc                        CRC-8 (poly 0x07, init 0) of all bytes before
+//
+// Histogram bin 0 counts values (>> TELEMETRY_HIST_SHIFT) of 0, bin k
+// counts values in [2^(k-1), 2^k), the last bin also counts all above.
+// Values are not saturated, they wrap around.
+
+#ifndef TELEMETRY_NUM_COUNTERS
+#define TELEMETRY_NUM_COUNTERS 4
+#endif
+
+#ifndef TELEMETRY_NUM_HISTS
+#define TELEMETRY_NUM_HISTS 2
+#endif
+
+#ifndef TELEMETRY_HIST_BINS
+#define TELEMETRY_HIST_BINS 12
+#endif
+
+// Right shift applied to histogram values, e.g. 3 for [us] values of timemeas_now_us() (8us ticks)
+#ifndef TELEMETRY_HIST_SHIFT
+#define TELEMETRY_HIST_SHIFT 3
+#endif
+
+#ifdef TELEMETRY
+
+// Sets up the software UART on portb_pin
+void telemetry_init(const uint8_t portb_pin);
+
+// Increments counter idx
+void telemetry_count(uint8_t idx);
+
+// Adds n to counter idx
+void telemetry_add(uint8_t idx, uint16_t n);
+
+// Counts value in histogram idx
+void telemetry_hist(uint8_t idx, uint16_t value);
+
+#ifdef ZZZ_STATS
+// Adds the time [ms] per sleep state (ZZZ_ACTIVE..ZZZ_PWR_DOWN, see zzz.h)
+// since the last call to counters idx..idx + ZZZ_NUM_STATES - 1. Call it
+// right before telemetry_send(), with TELEMETRY_NUM_COUNTERS large enough
+void telemetry_zzz_stats(uint8_t idx);
+#else
+#define telemetry_zzz_stats(idx) ((void)0)
+#endif
+
+// Sends a frame of all values and clears them. interval [ms] is passed
+// through, to let the decoder calculate rates
+void telemetry_send(const uint8_t portb_pin, uint8_t source, uint16_t interval);
+
+#else
+
+#define telemetry_init(portb_pin) ((void)0)
+#define telemetry_count(idx) ((void)0)
+#define telemetry_add(idx, n) ((void)0)
+#define telemetry_zzz_stats(idx) ((void)0)
+#define telemetry_hist(idx, value) ((void)0)
+#define telemetry_send(portb_pin, source, interval) ((void)0)
+
+#endif
+
+#endif
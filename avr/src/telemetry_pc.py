@@ -0,0 +1,147 @@
+# Copyright (c) 2023-2025 Alexander Scholz
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+import serial
+import struct
+import sys
+
+
+# Decoder for the telemetry frames of the AVR examples, see telemetry.h.
+# Connect a USB-UART adapter (RX, GND) to the telemetry pin.
+#   python telemetry_pc.py [COM_PORT] [BAUD]
+COM_PORT = "COM6"
+BAUD = 115200  # SUART_BAUD, 19200 for F_CPU 1MHz
+
+SYNC = b"\x55\xaa"
+HEADER_LEN = 9  # sync, source, seq, counters, hists, bins, interval
+HIST_SHIFT = 3  # TELEMETRY_HIST_SHIFT, histogram values in [us]
+
+# Names of the counters and histograms, per source (see the example's main.c)
+# Counters 4..7 are only sent with ZZZ_STATS (time per sleep state, see zzz.h)
+ZZZ_NAMES = ["active [ms]", "idle [ms]", "adc sleep [ms]", "power-down [ms]"]
+SOURCES = {
+    1: ("hot_wire", ["loops", "games", "wake-ups", "-"] + ZZZ_NAMES, ["choreo tick [us]", "loop [us]"]),
+    2: ("moodlight", ["loops", "frames", "mode switches", "wake-ups"] + ZZZ_NAMES, ["frame [us]", "frame period [us]"]),
+}
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xff if crc & 0x80 else (crc << 1) & 0xff
+    return crc
+
+
+def bin_label(k, num_bins):
+    if k == 0:
+        return "0"
+    lo = (1 << (k - 1)) << HIST_SHIFT
+    if k == num_bins - 1:
+        return f">={lo}"
+    return f"{lo}-{((1 << k) << HIST_SHIFT) - 1}"
+
+
+def read_frame(ser):
+    """Returns the next valid frame as dict, or None on timeout"""
+    window = b""
+    while True:
+        b = ser.read(1)
+        if not b:
+            return None
+        window = (window + b)[-2:]
+        if window != SYNC:
+            continue
+
+        header = ser.read(HEADER_LEN - 2)
+        if len(header) < HEADER_LEN - 2:
+            return None
+        source, seq, num_counters, num_hists, num_bins, interval = struct.unpack("<BBBBBH", header)
+
+        num_values = num_counters + num_hists * num_bins
+        body = ser.read(num_values * 2 + 1)
+        if len(body) < num_values * 2 + 1:
+            return None
+
+        if crc8(SYNC + header + body[:-1]) != body[-1]:
+            print("CRC error, frame dropped")
+            window = b""
+            continue
+
+        values = struct.unpack(f"<{num_values}H", body[:-1])
+        return {
+            "source": source,
+            "seq": seq,
+            "interval": interval,
+            "counters": values[:num_counters],
+            "hists": [values[num_counters + i * num_bins:num_counters + (i + 1) * num_bins] for i in range(num_hists)],
+        }
+
+
+def print_frame(frame, seq_last):
+    name, counter_names, hist_names = SOURCES.get(frame["source"], (f"source {frame['source']}", [], []))
+    lost = "" if seq_last is None else (frame["seq"] - seq_last - 1) & 0xff
+    print(f"--- {name}, frame {frame['seq']}, {frame['interval']} ms"
+          f"{f', {lost} frame(s) lost' if lost else ''}")
+
+    interval_s = frame["interval"] / 1000.0 if frame["interval"] else None
+    for i, value in enumerate(frame["counters"]):
+        label = counter_names[i] if i < len(counter_names) else f"counter {i}"
+        rate = f" ({value / interval_s:.1f}/s)" if interval_s else ""
+        print(f"  {label:<20} {value:>6}{rate}")
+
+    for i, bins in enumerate(frame["hists"]):
+        label = hist_names[i] if i < len(hist_names) else f"histogram {i}"
+        total = sum(bins)
+        print(f"  {label} ({total} values)")
+        for k, count in enumerate(bins):
+            if count:
+                bar = "#" * max(1, round(40 * count / total))
+                print(f"    {bin_label(k, len(bins)):>12} {count:>6} {bar}")
+
+
+def main():
+    port = sys.argv[1] if len(sys.argv) > 1 else COM_PORT
+    baud = int(sys.argv[2]) if len(sys.argv) > 2 else BAUD
+
+    try:
+        ser = serial.Serial(port=port, baudrate=baud, timeout=5)
+    except serial.serialutil.SerialException as e:
+        sys.exit(f"Goodbye. {e}")
+
+    print(f"Listening on {port} ({baud} baud)...")
+
+    seq_last = None
+    try:
+        while True:
+            frame = read_frame(ser)
+            if frame is None:
+                print("No frame received.")
+                continue
+            print_frame(frame, seq_last)
+            seq_last = frame["seq"]
+    except KeyboardInterrupt:
+        pass
+    finally:
+        ser.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -21,14 +21,152 @@ SOFTWARE.
 */
 #include <stdint.h>
 #include <avr/interrupt.h>
+#include "timemeas.h"
+#include "zzz.h"
+
+#ifdef DEBOUNCE_ISR_PINS
+#include "debounce.h"
+#ifdef TIMEMEAS_TICKLESS
+#error DEBOUNCE_ISR_PINS requires 1ms ticks, it cannot be combined with TIMEMEAS_TICKLESS
+#endif
+#endif
+
+#ifdef ADC_TIMER0
+#include "adc.h"
+#ifdef TIMEMEAS_TICKLESS
+#error ADC_TIMER0 requires 1ms ticks, it cannot be combined with TIMEMEAS_TICKLESS
+#endif
+#endif
+
+// Clock Select of Timer0 for 1ms periods (125kHz, 8us ticks), see timemeas_init()
+#if F_CPU == 1000000
+#define CS_FINE (1 << CS01)
+#elif F_CPU == 8000000
+#define CS_FINE ((1 << CS00) | (1 << CS01))
+#else
+#error Time measure is only configured for an I/O Clock of 1MHz or 8MHz
+#endif
+
+#ifdef TIMEMEAS_TICKLESS
+// Clock Select of Timer0 while sleeping in tickless mode, and its tick in
+// fine ticks (8us):
+//  F_CPU == 1000000: I/O Clock divided by 256 -> 256us ticks
+//  F_CPU == 8000000: I/O Clock divided by 1024 -> 128us ticks
+// One period (OCR0A = 255) takes up to 65ms or 32ms, respectively.
+#if F_CPU == 1000000
+#define CS_COARSE (1 << CS02)
+#define FINE_PER_COARSE 32
+#else
+#define CS_COARSE ((1 << CS02) | (1 << CS00))
+#define FINE_PER_COARSE 16
+#endif
+#endif
 
 volatile uint32_t now = 0;
 volatile uint8_t now_guard = 0;
 
+// Set by the ISR, to tell Timer0 wake-ups from others
+volatile uint8_t ticked = 0;
+
+#ifdef TIMEMEAS_TICKLESS
+volatile uint8_t coarse = 0;     // Timer0 runs with CS_COARSE
+volatile uint8_t frac = 0;       // Fine ticks on top of now, while coarse
+volatile uint8_t sleeping = 0;   // timemeas_sleep_until() is waiting for wake_time
+volatile uint32_t wake_time = 0; // [ms]
+
+// Switches Timer0 to 1ms periods, continuing from frac.
+// Only call with the period just started (ISR) or interrupts disabled.
+static void timemeas_go_fine(void)
+{
+    TCCR0B = (TCCR0B & ~((1 << CS02) | (1 << CS01) | (1 << CS00))) | CS_FINE;
+    GTCCR |= (1 << PSR0); // Restart the prescaler with the new clock
+    OCR0A = 124;
+    TCNT0 = frac;
+    frac = 0;
+    coarse = 0;
+}
+
+// Plans the next Timer0 period, called by the ISR at the start of a period.
+// While sleeping, the period is stretched (coarse clock) to end shortly
+// before wake_time. The rest is done with 1ms periods.
+static void timemeas_plan(void)
+{
+    uint16_t ticks = 0; // Coarse ticks of the next period
+
+    if (sleeping)
+    {
+        int32_t remaining = wake_time - now;
+
+        if (remaining > 1000)
+        {
+            ticks = 256;
+        }
+        else if (remaining >= TIMEMEAS_TICKLESS_MIN_MS)
+        {
+            ticks = ((uint32_t)remaining * 125 - frac) / FINE_PER_COARSE;
+            if (ticks > 256)
+            {
+                ticks = 256;
+            }
+        }
+    }
+
+    if (ticks >= 2)
+    {
+        if (!coarse)
+        {
+            TCCR0B = (TCCR0B & ~((1 << CS02) | (1 << CS01) | (1 << CS00))) | CS_COARSE;
+            GTCCR |= (1 << PSR0); // Restart the prescaler with the new clock
+            TCNT0 = 0;
+            coarse = 1;
+        }
+        OCR0A = ticks - 1;
+    }
+    else if (coarse)
+    {
+        timemeas_go_fine();
+    }
+}
+#endif
+
 ISR(TIMER0_COMPA_vect)
 {
     now_guard = 1;
+    ticked = 1;
+
+#ifdef TIMEMEAS_TICKLESS
+    if (coarse)
+    {
+        uint16_t fine = frac + (uint16_t)(OCR0A + 1) * FINE_PER_COARSE;
+        now += fine / 125;
+        frac = fine % 125;
+    }
+    else
+    {
+        now++;
+    }
+
+    if (sleeping || coarse)
+    {
+        timemeas_plan();
+    }
+#else
     now++;
+#endif
+
+#ifdef ADC_TIMER0
+    // Collect the conversion triggered by the previous compare match, see adc.h
+    adc_isr_tick();
+#endif
+
+#ifdef DEBOUNCE_ISR_PINS
+    // Debounce inputs independent of the main loop, see debounce.h.
+    // A new input event ends timemeas_sleep_until(), like another interrupt
+    if (debounce_isr_tick(now))
+    {
+        ticked = 0;
+    }
+#endif
 }
 
 void timemeas_init(void)
@@ -39,13 +177,7 @@ void timemeas_init(void)
     // Set Clock Select: I/O Clock divided by 8 or 64.
     // The I/O Clock is the "base clock" (e.g. the internal crystal),
     // divided by the System Clock Prescaler (e.g. set via fuse)
-#if F_CPU == 1000000
-    TCCR0B |= (1 << CS01); // Timer/Counter Control Register B (TCCR0B)
-#elif F_CPU == 8000000
-    TCCR0B |= (1 << CS00) | (1 << CS01); // Timer/Counter Control Register B (TCCR0B)
-#else
-#error Time measure is only configured for an I/O Clock of 1MHz or 8MHz
-#endif
+    TCCR0B |= CS_FINE; // Timer/Counter Control Register B (TCCR0B)
 
     // Set output compare value.
     // The value of the Timer/Counter Register (TCNT0) is continuously
@@ -69,8 +201,59 @@ void timemeas_init(void)
     TIMSK |= (1 << OCIE0A); // Timer/Counter Interrupt Mask Register (TIMSK)
 }
 
+// Reads now and the fine ticks (8us) elapsed since it was last updated
+static uint32_t timemeas_read(uint16_t *fine)
+{
+    uint32_t ms;
+    uint8_t tcnt;
+    uint8_t top;
+    uint8_t pending;
+#ifdef TIMEMEAS_TICKLESS
+    uint8_t is_coarse;
+    uint8_t frac_ticks;
+#endif
+    do
+    {
+        now_guard = 0;
+        ms = now;
+        tcnt = TCNT0;
+        top = OCR0A;
+        pending = TIFR & (1 << OCF0A);
+#ifdef TIMEMEAS_TICKLESS
+        is_coarse = coarse;
+        frac_ticks = frac;
+#endif
+    } while (now_guard);
+
+    // A compare match occurred, but the ISR did not run yet (e.g. interrupts
+    // disabled): the counter already restarted from 0, unless it still reads
+    // OCR0A (it is cleared on the next tick)
+    uint8_t wrapped = (pending && tcnt < top);
+
+#ifdef TIMEMEAS_TICKLESS
+    if (is_coarse)
+    {
+        *fine = frac_ticks + ((uint16_t)tcnt + (wrapped ? (uint16_t)top + 1 : 0)) * FINE_PER_COARSE;
+        return ms;
+    }
+#endif
+
+    *fine = tcnt + (wrapped ? 125 : 0);
+    return ms;
+}
+
 uint32_t timemeas_now(void)
 {
+#ifdef TIMEMEAS_TICKLESS
+    // Only while sleeping (e.g. called by another ISR), now may lag behind
+    if (coarse)
+    {
+        uint16_t fine;
+        uint32_t ms = timemeas_read(&fine);
+        return ms + fine / 125;
+    }
+#endif
+
     uint32_t ret;
     do
     {
@@ -79,3 +262,66 @@ uint32_t timemeas_now(void)
     } while (now_guard);
     return ret;
 }
+
+uint32_t timemeas_now_us(void)
+{
+    uint16_t fine;
+    uint32_t ms = timemeas_read(&fine);
+
+    // ms * 1000 + fine * 8, without multiplication (no MUL on ATtiny)
+    return (ms << 10) - (ms << 4) - (ms << 3) + ((uint32_t)fine << 3);
+}
+
+void timemeas_advance(uint32_t ms)
+{
+    uint8_t sreg = SREG;
+    cli();
+    now += ms;
+    SREG = sreg;
+}
+
+#ifdef TIMEMEAS_TICKLESS
+// Ends the sleep of timemeas_sleep_until(). If woken up by another interrupt
+// during a coarse period, continues with 1ms periods right away. A pending
+// compare match is left to the ISR.
+// The prescaler is restarted, which drops the partly counted coarse tick.
+// Half a coarse tick is added for it, the mean of what is lost.
+static void timemeas_wake(void)
+{
+    cli();
+    sleeping = 0;
+    if (coarse && !(TIFR & (1 << OCF0A)))
+    {
+        uint16_t fine = frac + (uint16_t)TCNT0 * FINE_PER_COARSE + FINE_PER_COARSE / 2;
+        now += fine / 125;
+        frac = fine % 125;
+        timemeas_go_fine();
+    }
+    sei();
+}
+#endif
+
+void timemeas_sleep_until(uint32_t wake)
+{
+    while ((int32_t)(timemeas_now() - wake) < 0)
+    {
+        cli();
+        ticked = 0;
+#ifdef TIMEMEAS_TICKLESS
+        wake_time = wake;
+        sleeping = 1;
+#endif
+        // Idle, as Timer0 is armed (see zzz_sleep_armed()). Interrupts stay
+        // disabled until right before, so no tick is missed
+        zzz_sleep_armed();
+
+        if (!ticked)
+        {
+            break; // Woken up by another interrupt, let the caller handle it
+        }
+    }
+
+#ifdef TIMEMEAS_TICKLESS
+    timemeas_wake();
+#endif
+}
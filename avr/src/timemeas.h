@@ -24,10 +24,40 @@ SOFTWARE.
 
 #include <stdint.h>
 
+// Tickless mode (define TIMEMEAS_TICKLESS, e.g. in the Makefile):
+// While timemeas_sleep_until() sleeps, Timer0 runs with a slower clock and
+// only interrupts every ~32ms (F_CPU 8MHz) or ~65ms (1MHz), instead of every
+// 1ms. timemeas_now() stays monotonic. Switching the clock restarts the
+// prescaler: at the end of a coarse period this loses a few CPU cycles. If
+// another interrupt wakes up the CPU during a coarse period, the partly
+// counted coarse tick is lost, up to 128us (8MHz) or 256us (1MHz). Half a
+// tick is added instead, so each such wake-up is off by up to +-64us or
+// +-128us, without drifting on average.
+
+// Min. time [ms] to sleep in timemeas_sleep_until(), to switch to the slower clock
+#ifndef TIMEMEAS_TICKLESS_MIN_MS
+#define TIMEMEAS_TICKLESS_MIN_MS 4
+#endif
+
 // Initializes time measure
 void timemeas_init(void);
 
 // Returns time [ms] since init
 uint32_t timemeas_now(void);
 
+// Returns time [us] since init, with a resolution of 8us (Timer0 ticks).
+// Wraps around after ~71 minutes, so only use it for differences.
+uint32_t timemeas_now_us(void);
+
+// Adds ms [ms] to the time, for periods Timer0 was stopped
+// (e.g. power-down sleep, see zzz_sleep_for()). Leaves the interrupt flag
+// as it was
+void timemeas_advance(uint32_t ms);
+
+// Sleeps (SLEEP_MODE_IDLE) until timemeas_now() reaches wake [ms].
+// Returns early, if another interrupt (e.g. pin change) woke up the CPU, or
+// the Timer0 ISR queued an input event (DEBOUNCE_ISR_PINS, see debounce.h).
+// Interrupts must be enabled.
+void timemeas_sleep_until(uint32_t wake);
+
 #endif
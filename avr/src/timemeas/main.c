@@ -21,6 +21,7 @@ SOFTWARE.
 */
 #include <avr/interrupt.h>
 #include "../timemeas.h"
+#include "../simbench.h"
 
 #define BLINK_DELAY_MS 500
 
@@ -58,6 +59,8 @@ int main(void)
     setup();
     while (1)
     {
+        SIM_LOOP_MARK();
+
         loop();
     }
 }
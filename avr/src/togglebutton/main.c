@@ -23,6 +23,7 @@ SOFTWARE.
 #include <avr/io.h>
 #include "../timemeas.h"
 #include "../debounce.h"
+#include "../simbench.h"
 
 int main(void)
 {
@@ -52,6 +53,8 @@ int main(void)
 
     while (1)
     {
+        SIM_LOOP_MARK();
+
         // If PINB2 is LOW, the button is pressed (button_state_raw = 1)
         uint8_t button_state_raw = (PINB & (1 << PINB2)) ? 0 : 1;
 
@@ -21,6 +21,9 @@ SOFTWARE.
 */
 #include <avr/io.h>
 #include <stdint.h>
+#include <util/delay.h>
+#include "flash.h"
+#include "ws2812b.h"
 
 /*
 This implementation assumes that the LOW part (always 2nd part) of a data bit
@@ -118,3 +121,218 @@ void ws2812b_bang_byte(const uint8_t portb_pin, const uint8_t data)
         : [pb_hi] "r"(pb_hi), [pb_lo] "r"(pb_lo), [data] "r"(data) // Inputs
         : "r16", "r17");                                           // Clobbered registers
 }
+
+/*
+Sends len (> 0) bytes from buf in one loop. No latch.
+
+Same HIGH times as ws2812b_bang_byte(). Cycles per bit (@ 8MHz):
+
+  0  out  HIGH
+  1  nop
+  2  sbrs data,7     (bit 0: 1 cycle, bit 1: 2 cycles, skipping the next out)
+  3  out  LOW        (bit 0: HIGH for 3 cycles)
+  4  nop
+  5  nop
+  6  nop
+  (+4 nops for APA106)
+  7  out  LOW        (bit 1: HIGH for 7 cycles)
+  8  lsl  data
+  9  dec  ctr
+  10 brne (2 cycles) -> 12 cycles (1.5us) per bit, 16 for APA106
+
+Between bytes, the line stays LOW for 7 more cycles (restore SREG, count,
+load the next byte). Interrupts are disabled while a byte is sent, and
+pending interrupts are served between bytes, which only stretches the LOW
+time. An ISR must therefore stay well below the reset time.
+*/
+static inline void ws2812b_send_bytes(const uint8_t pb_hi, const uint8_t pb_lo, const uint8_t *buf, uint16_t len)
+{
+#if F_CPU != 8000000UL
+#error ws2812b_send_bytes() is only implemented for 8MHz
+#endif
+
+    uint8_t data;
+    uint8_t ctr;
+    uint8_t sreg;
+
+    __asm__ volatile(
+        "in %[sreg],0x3f\n" // Save SREG (interrupt flag)
+
+        ".frame_byte%=:\n"
+        "ld %[data],%a[buf]+\n" // Load next byte
+        "ldi %[ctr],8\n"
+        "cli\n"
+
+        ".frame_bit%=:\n"
+        "out 0x18,%[pb_hi]\n" // Set HIGH
+        "nop\n"
+        "sbrs %[data],7\n"     // Bit set: skip setting LOW early
+        "out 0x18,%[pb_lo]\n" // Set LOW (zero)
+        "nop\n"
+        "nop\n"
+        "nop\n"
+#ifdef AVR_LAB_APA106
+        "nop\n"
+        "nop\n"
+        "nop\n"
+        "nop\n"
+#endif
+        "out 0x18,%[pb_lo]\n" // Set LOW (one)
+
+        // Prepare next bit
+        "lsl %[data]\n"
+        "dec %[ctr]\n"
+        "brne .frame_bit%=\n"
+
+        // Byte done, pending interrupts are served here (LOW)
+        "out 0x3f,%[sreg]\n"
+        "sbiw %[len],1\n"
+        "brne .frame_byte%=\n"
+
+        : [data] "=&r"(data), [ctr] "=&d"(ctr), [sreg] "=&r"(sreg), [buf] "+e"(buf), [len] "+w"(len) // Outputs
+        : [pb_hi] "r"(pb_hi), [pb_lo] "r"(pb_lo)                                                     // Inputs
+        : "memory");                                                                                 // Clobbered
+}
+
+// A 24 LED frame (72 bytes) takes about 72 * 103 cycles = 0.93ms by the
+// cycle count above, plus the reset time. The cycle benchmark (avr/sim)
+// measures it (strip.frame.us.mean) and checks the 12 (16) cycles per bit.
+void ws2812b_send_frame(const uint8_t portb_pin, const uint8_t *buf, uint16_t len)
+{
+    if (len == 0)
+    {
+        return;
+    }
+
+    const uint8_t pb = PORTB;
+    const uint8_t pb_hi = (pb | (1 << portb_pin));
+    const uint8_t pb_lo = (pb & ~(1 << portb_pin));
+
+    ws2812b_send_bytes(pb_hi, pb_lo, buf, len);
+
+    // Latch
+    _delay_us(WS2812B_RESET_US);
+}
+
+#ifdef WS2812B_STREAM_CHECK
+uint8_t ws2812b_gen_max_ticks = 0;
+uint16_t ws2812b_gen_overruns = 0;
+#endif
+
+/*
+The generator runs while the line is LOW after the previous pixel, so its
+run time adds to that LOW time. Together with an ISR served between bytes,
+it must stay below the reset time (50us), or the strip latches mid-frame.
+
+Cycle budget per pixel (@ 8MHz):
+  24 bits * 12 cycles     288  transmission (384 for APA106)
+  call of the generator   ~20  (call, pointer argument, return)
+  generator               WS2812B_GEN_BUDGET_CYCLES (default 160 = 20us)
+  Timer0 ISR (timemeas)   ~60
+-> LOW time between pixels stays below ~30us, well below the reset time.
+
+The moodlight generator (palette index from a sequence, 3 flash reads,
+no modulo) takes about 40 cycles.
+
+With WS2812B_STREAM_CHECK defined, the generator run time is measured with
+Timer0 (requires timemeas, 8us ticks, so it is coarse) and runs over budget
+are counted in ws2812b_gen_overruns.
+*/
+void ws2812b_send_stream(const uint8_t portb_pin, uint16_t num_pixels, ws2812b_pixel_gen gen, void *ctx)
+{
+    const uint8_t pb = PORTB;
+    const uint8_t pb_hi = (pb | (1 << portb_pin));
+    const uint8_t pb_lo = (pb & ~(1 << portb_pin));
+    uint8_t grb[3];
+
+    while (num_pixels--)
+    {
+#ifdef WS2812B_STREAM_CHECK
+        uint8_t tcnt_start = TCNT0;
+#endif
+
+        gen(grb, ctx);
+
+#ifdef WS2812B_STREAM_CHECK
+        uint8_t tcnt_end = TCNT0;
+        uint8_t ticks = (tcnt_end >= tcnt_start) ? (tcnt_end - tcnt_start)
+                                                 : (tcnt_end + OCR0A + 1 - tcnt_start);
+        if (ticks > ws2812b_gen_max_ticks)
+        {
+            ws2812b_gen_max_ticks = ticks;
+        }
+        // 64 cycles per Timer0 tick @ 8MHz
+        if (ticks > WS2812B_GEN_BUDGET_CYCLES / 64)
+        {
+            ws2812b_gen_overruns++;
+        }
+#endif
+
+        ws2812b_send_bytes(pb_hi, pb_lo, grb, 3);
+    }
+
+    // Latch
+    _delay_us(WS2812B_RESET_US);
+}
+
+/*
+Compared to a GRB frame buffer, a 4 bit frame buffer needs 1/6 of the SRAM
+(e.g. 12 instead of 72 bytes for 24 LEDs).
+
+The palette lookup (nibble, index * 3, 3 flash reads) takes about 25 cycles
+and extends the LOW time between two pixels by about 3us. From SRAM
+(palette_in_flash 0), it is a few cycles less.
+*/
+static inline void ws2812b_send_fb4_from(const uint8_t portb_pin, const uint8_t *fb, uint16_t num_pixels,
+                                         const uint8_t (*palette)[3], const uint8_t palette_in_flash)
+{
+    const uint8_t pb = PORTB;
+    const uint8_t pb_hi = (pb | (1 << portb_pin));
+    const uint8_t pb_lo = (pb & ~(1 << portb_pin));
+    uint8_t grb[3];
+    uint8_t packed = 0;
+
+    for (uint16_t i = 0; i < num_pixels; i++)
+    {
+        // Two pixels per byte, low nibble first
+        uint8_t color_idx;
+        if (i & 1)
+        {
+            color_idx = packed >> 4;
+        }
+        else
+        {
+            packed = *fb++;
+            color_idx = packed & 0x0f;
+        }
+
+        const uint8_t *color = palette[color_idx];
+        if (palette_in_flash)
+        {
+            grb[0] = flash_u8(&color[0]);
+            grb[1] = flash_u8(&color[1]);
+            grb[2] = flash_u8(&color[2]);
+        }
+        else
+        {
+            grb[0] = color[0];
+            grb[1] = color[1];
+            grb[2] = color[2];
+        }
+
+        ws2812b_send_bytes(pb_hi, pb_lo, grb, 3);
+    }
+
+    // Latch
+    _delay_us(WS2812B_RESET_US);
+}
+
+void ws2812b_send_fb4(const uint8_t portb_pin, const uint8_t *fb, uint16_t num_pixels, const uint8_t (*palette)[3])
+{
+    ws2812b_send_fb4_from(portb_pin, fb, num_pixels, palette, 1);
+}
+
+void ws2812b_send_fb4_ram(const uint8_t portb_pin, const uint8_t *fb, uint16_t num_pixels, const uint8_t (*palette)[3])
+{
+    ws2812b_send_fb4_from(portb_pin, fb, num_pixels, palette, 0);
+}
@@ -24,7 +24,67 @@ SOFTWARE.
 
 #include <stdint.h>
 
+// Time [us] the data line is held LOW after a frame, to latch it (reset time).
+// Some newer WS2812B variants need up to 280us.
+#ifndef WS2812B_RESET_US
+#define WS2812B_RESET_US 60
+#endif
+
+// Max. run time [cycles] of a pixel generator, see ws2812b_send_stream()
+#ifndef WS2812B_GEN_BUDGET_CYCLES
+#define WS2812B_GEN_BUDGET_CYCLES 160
+#endif
+
+// Pixel generator: writes the GRB bytes of the next pixel to grb[0..2]
+typedef void (*ws2812b_pixel_gen)(uint8_t *grb, void *ctx);
+
 // Sends a single byte (color value) via ws2812b protocol
 void ws2812b_bang_byte(const uint8_t portb_pin, const uint8_t data);
 
+// Sends a whole frame of len bytes (GRB per LED) via ws2812b protocol, and latches it
+void ws2812b_send_frame(const uint8_t portb_pin, const uint8_t *buf, uint16_t len);
+
+// Sends num_pixels pixels via ws2812b protocol, and latches them.
+// Each pixel is computed by gen right before it is sent, so no frame buffer is required.
+// gen must return within WS2812B_GEN_BUDGET_CYCLES (see ws2812b.c)
+void ws2812b_send_stream(const uint8_t portb_pin, uint16_t num_pixels, ws2812b_pixel_gen gen, void *ctx);
+
+// Size [bytes] of a 4 bit palette-indexed frame buffer (two pixels per byte)
+#define WS2812B_FB4_SIZE(num_pixels) (((num_pixels) + 1) / 2)
+
+// Sets pixel i of a 4 bit frame buffer to palette index color_idx (0..15)
+static inline void ws2812b_fb4_set(uint8_t *fb, uint16_t i, uint8_t color_idx)
+{
+    uint8_t *byte = &fb[i >> 1];
+    if (i & 1)
+    {
+        *byte = (*byte & 0x0f) | (color_idx << 4);
+    }
+    else
+    {
+        *byte = (*byte & 0xf0) | (color_idx & 0x0f);
+    }
+}
+
+// Returns the palette index of pixel i of a 4 bit frame buffer
+static inline uint8_t ws2812b_fb4_get(const uint8_t *fb, uint16_t i)
+{
+    return (i & 1) ? (fb[i >> 1] >> 4) : (fb[i >> 1] & 0x0f);
+}
+
+// Sends num_pixels pixels of a 4 bit frame buffer via ws2812b protocol, and latches them.
+// Each palette index is resolved to its GRB bytes right before the pixel is sent.
+// palette: up to 16 GRB colors, stored in flash (FLASH, see flash.h)
+void ws2812b_send_fb4(const uint8_t portb_pin, const uint8_t *fb, uint16_t num_pixels, const uint8_t (*palette)[3]);
+
+// Like ws2812b_send_fb4(), with the palette in SRAM (e.g. converted by gamma_palette(), see gamma.h)
+void ws2812b_send_fb4_ram(const uint8_t portb_pin, const uint8_t *fb, uint16_t num_pixels, const uint8_t (*palette)[3]);
+
+#ifdef WS2812B_STREAM_CHECK
+// Longest generator run time seen [Timer0 ticks, 8us]
+extern uint8_t ws2812b_gen_max_ticks;
+// Number of generator runs over WS2812B_GEN_BUDGET_CYCLES
+extern uint16_t ws2812b_gen_overruns;
+#endif
+
 #endif
@@ -23,10 +23,12 @@ SOFTWARE.
 #include <avr/io.h>
 #include <util/delay.h>
 #include "../ws2812b.h"
+#include "../flash.h"
+#include "../simbench.h"
 
 #define NUM_LED 24
 
-const uint8_t palette[][3] = {
+const uint8_t palette[][3] FLASH = {
     {63, 0, 0},  // Green
     {63, 63, 0}, // Yellow
     {25, 63, 0}, // Orange
@@ -35,9 +37,12 @@ const uint8_t palette[][3] = {
     {16, 0, 39}, // Blue
 };
 
-const uint8_t sequence[] = {0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5};
+const uint8_t sequence[] FLASH = {0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5};
 const uint8_t len_sequence = 12;
 
+// Palette index per LED (4 bit, two LEDs per byte)
+uint8_t frame_buf[WS2812B_FB4_SIZE(NUM_LED)];
+
 int main(void)
 {
     DDRB |= (1 << DDB1); // Port B data direction register (DDRB)
@@ -45,15 +50,17 @@ int main(void)
     uint8_t sequence0 = 0;
     while (1)
     {
-        // Bit-Banging. No fancy calculations in this loop!
+        SIM_LOOP_MARK();
+
+        // Compose frame
         for (uint8_t i = 0; i < NUM_LED; i++)
         {
-            uint8_t seq = sequence[(sequence0 + i) % len_sequence];
-            ws2812b_bang_byte(PB1, palette[seq][0]);
-            ws2812b_bang_byte(PB1, palette[seq][1]);
-            ws2812b_bang_byte(PB1, palette[seq][2]);
+            ws2812b_fb4_set(frame_buf, i, flash_u8(&sequence[(sequence0 + i) % len_sequence]));
         }
 
+        // Bit-Banging. Palette lookup happens while sending
+        ws2812b_send_fb4(PB1, frame_buf, NUM_LED, palette);
+
         sequence0 = (sequence0 + 1) % len_sequence;
         _delay_ms(100);
     }
@@ -21,19 +21,297 @@ SOFTWARE.
 */
 #include <stdint.h>
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include <avr/sleep.h>
+#include <avr/wdt.h>
+#include "zzz.h"
+
+#if defined(ZZZ_TIMEMEAS) || defined(ZZZ_STATS)
+#include "timemeas.h"
+#endif
+
+#ifdef ZZZ_STATS
+zzz_stats stats;
+#endif
+
+// Set by the ISR, to tell WDT wake-ups from others
+volatile uint8_t wdt_woke = 0;
+
+ISR(WDT_vect)
+{
+    wdt_woke = 1;
+}
+
+// Writes value to WDTCR, with the change enable (WDCE, WDE) right before.
+// Timed sequence: value must follow within 4 cycles, so it is computed
+// into a register before and both are written by two out instructions
+// (as wdt_enable() of avr-libc does). Only call with interrupts disabled
+static inline void zzz_wdt_write(uint8_t value)
+{
+#ifdef __AVR__
+    __asm__ volatile(
+        "out 0x21,%[enable]\n" // WDTCR
+        "out 0x21,%[value]\n"
+        :
+        : [enable] "r"((uint8_t)((1 << WDCE) | (1 << WDE))),
+          [value] "r"(value));
+#else
+    // Host build (avr/host), not timed
+    WDTCR = (1 << WDCE) | (1 << WDE);
+    WDTCR = value;
+#endif
+}
+
+// Starts the WDT in interrupt mode (no reset) with prescaler wdp (0: 16ms,
+// 9: 8s). Only call with interrupts disabled
+static void zzz_wdt_start(uint8_t wdp)
+{
+    uint8_t value = (1 << WDIF) | (1 << WDIE) | ((wdp & 8) ? (1 << WDP3) : 0) | (wdp & 7);
+
+    wdt_reset();
+    MCUSR &= ~(1 << WDRF); // WDE can not be cleared while WDRF is set
+    zzz_wdt_write(value);
+}
+
+// Stops the WDT. Only call with interrupts disabled
+static void zzz_wdt_stop(void)
+{
+    wdt_reset();
+    zzz_wdt_write(1 << WDIF);
+}
+
+// Sleeps once in mode, until an interrupt. Disables the BOD in power-down.
+// Interrupts are enabled right before, so one that is due wakes up at once
+static void zzz_sleep_cpu(uint8_t mode)
+{
+    set_sleep_mode(mode);
+    cli();
+    sleep_enable();
+    if (mode == SLEEP_MODE_PWR_DOWN)
+    {
+        sleep_bod_disable(); // Timed sequence, sleep_cpu() must follow within 3 cycles
+    }
+    sei();
+    sleep_cpu(); // Executed right after sei(), before any pending interrupt
+    sleep_disable();
+}
+
+void zzz_power_off(uint8_t pr)
+{
+    if (pr & (1 << PRADC))
+    {
+        ADCSRA &= ~(1 << ADEN);
+    }
+    PRR |= pr;
+}
+
+void zzz_power_on(uint8_t pr)
+{
+    PRR &= ~pr;
+}
+
+uint8_t zzz_wake_sources(void)
+{
+    uint8_t wake = 0;
+
+    if (GIMSK & ((1 << PCIE) | (1 << INT0)))
+    {
+        wake |= ZZZ_WAKE_PIN;
+    }
+    if (WDTCR & (1 << WDIE))
+    {
+        wake |= ZZZ_WAKE_WDT;
+    }
+    if ((ADCSRA & ((1 << ADEN) | (1 << ADIE))) == ((1 << ADEN) | (1 << ADIE)) && !(PRR & (1 << PRADC)))
+    {
+        wake |= ZZZ_WAKE_ADC;
+    }
+    if ((TIMSK & ((1 << OCIE0A) | (1 << OCIE0B) | (1 << TOIE0))) &&
+        (TCCR0B & ((1 << CS02) | (1 << CS01) | (1 << CS00))) && !(PRR & (1 << PRTIM0)))
+    {
+        wake |= ZZZ_WAKE_CLOCKED;
+    }
+    if ((TIMSK & ((1 << OCIE1A) | (1 << OCIE1B) | (1 << TOIE1))) &&
+        (TCCR1 & ((1 << CS13) | (1 << CS12) | (1 << CS11) | (1 << CS10))) && !(PRR & (1 << PRTIM1)))
+    {
+        wake |= ZZZ_WAKE_CLOCKED;
+    }
+    if ((USICR & ((1 << USISIE) | (1 << USIOIE))) && !(PRR & (1 << PRUSI)))
+    {
+        wake |= ZZZ_WAKE_CLOCKED;
+    }
+
+    return wake;
+}
+
+uint8_t zzz_mode_for(uint8_t wake)
+{
+    if (wake & ZZZ_WAKE_CLOCKED)
+    {
+        return SLEEP_MODE_IDLE;
+    }
+    if (wake & ZZZ_WAKE_ADC)
+    {
+        return SLEEP_MODE_ADC;
+    }
+    return SLEEP_MODE_PWR_DOWN;
+}
+
+void zzz_sleep_armed(void)
+{
+    uint8_t mode = zzz_mode_for(zzz_wake_sources());
+
+#ifdef ZZZ_STATS
+    uint32_t start = timemeas_now();
+#endif
+
+    zzz_sleep_cpu(mode);
+
+    // Timer0 only runs in idle, the other modes are counted without time
+    if (mode == SLEEP_MODE_IDLE)
+    {
+        zzz_stats_add(ZZZ_IDLE, timemeas_now() - start);
+    }
+    else
+    {
+        zzz_stats_add(mode == SLEEP_MODE_ADC ? ZZZ_ADC : ZZZ_PWR_DOWN, 0);
+    }
+}
+
+// Power-down sleep for up to ms, see zzz_sleep_for(). With ZZZ_TIMEMEAS,
+// the time slept is merged into timemeas
+static uint8_t zzz_sleep_wdt(uint16_t ms)
+{
+    uint16_t slept;
+    uint8_t full = zzz_sleep_for(ms, &slept);
+#ifdef ZZZ_TIMEMEAS
+    timemeas_advance(slept);
+#endif
+    return full;
+}
 
 void zzz_sleep(void)
 {
+#ifdef ZZZ_TIMEMEAS
+    // Keep time with the WDT, until woken up by another interrupt
+    while (zzz_sleep_wdt(ZZZ_WDT_MAX_MS))
+    {
+    }
+#else
     uint8_t adcsra_last = ADCSRA;
 
     // disable ADCs
     ADCSRA &= ~(1 << ADEN);
 
-    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
-    sleep_enable();
-    sleep_cpu(); // Actual power-down. Wake up by e.g. Pin Change Interrupt
-    sleep_disable();
+    // Actual power-down. Wake up by e.g. Pin Change Interrupt
+    zzz_sleep_cpu(SLEEP_MODE_PWR_DOWN);
 
     ADCSRA = adcsra_last;
+
+    // The time slept is not known
+    zzz_stats_add(ZZZ_PWR_DOWN, 0);
+#endif
+}
+
+uint8_t zzz_sleep_for(uint16_t ms, uint16_t *slept)
+{
+    uint8_t adcsra_last = ADCSRA;
+    uint8_t full = 1;
+    *slept = 0;
+
+    // disable ADCs
+    ADCSRA &= ~(1 << ADEN);
+
+    while (ms >= ZZZ_WDT_MIN_MS)
+    {
+        // Longest WDT period that fits
+        uint8_t wdp = 0;
+        uint16_t period = ZZZ_WDT_MIN_MS;
+        while (period < ZZZ_WDT_MAX_MS && (period << 1) <= ms)
+        {
+            wdp++;
+            period <<= 1;
+        }
+
+        cli();
+        wdt_woke = 0;
+        zzz_wdt_start(wdp);
+        zzz_sleep_cpu(SLEEP_MODE_PWR_DOWN);
+
+        if (!wdt_woke)
+        {
+            // Woken up by another interrupt. The WDT counter can not be
+            // read, so half the period is a best guess
+            *slept += period >> 1;
+            full = 0;
+            break;
+        }
+
+        *slept += period;
+        ms -= period;
+    }
+
+    cli();
+    zzz_wdt_stop();
+    sei();
+
+    ADCSRA = adcsra_last;
+
+    zzz_stats_add(ZZZ_PWR_DOWN, *slept);
+
+    return full;
+}
+
+uint8_t zzz_pins_pressed(uint8_t pins)
+{
+    uint8_t pressed = (~PINB & pins) != 0;
+    uint8_t same = 0;
+
+    while (same < ZZZ_WAKE_SAMPLES)
+    {
+        // A pin change (bounce) ends the sample period early
+        zzz_sleep_wdt(ZZZ_WDT_MIN_MS);
+
+        uint8_t sample = (~PINB & pins) != 0;
+        if (sample == pressed)
+        {
+            same++;
+        }
+        else
+        {
+            pressed = sample;
+            same = 0;
+        }
+    }
+
+    return pressed;
+}
+
+void zzz_sleep_pressed(uint8_t pins)
+{
+    // Wait for a held press (e.g. the one that sent us to sleep) to be released
+    while (zzz_pins_pressed(pins))
+    {
+        zzz_sleep();
+    }
+
+    // A pin change that does not settle as a press was bounce or a release
+    do
+    {
+        zzz_sleep();
+    } while (!zzz_pins_pressed(pins));
+}
+
+#ifdef ZZZ_STATS
+void zzz_stats_add(uint8_t state, uint32_t ms)
+{
+    stats.ms[state] += ms;
+    stats.sleeps[state]++;
+}
+
+void zzz_stats_get(zzz_stats *dst)
+{
+    *dst = stats;
+    dst->ms[ZZZ_ACTIVE] = timemeas_now() - stats.ms[ZZZ_IDLE] - stats.ms[ZZZ_ADC] - stats.ms[ZZZ_PWR_DOWN];
 }
+#endif
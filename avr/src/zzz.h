@@ -22,6 +22,127 @@ SOFTWARE.
 #ifndef ZZZ_H
 #define ZZZ_H
 
+#include <stdint.h>
+
+// Sleep and power reduction.
+//
+// Sleep modes of the ATtiny85, and what keeps running:
+//   SLEEP_MODE_IDLE      I/O clock: Timer0/1, USI, ADC, all interrupts
+//   SLEEP_MODE_ADC       ADC, WDT, pin change (Timer0 stops)
+//   SLEEP_MODE_PWR_DOWN  WDT, pin change only (Timer0 stops)
+// In power-down, the brown-out detector (BOD, if enabled by fuse) is
+// disabled during sleep (~20uA less). Peripherals that are not used at all
+// should be powered off (zzz_power_off()), which also saves current while
+// active or idle.
+
+// Wake sources, see zzz_wake_sources()
+#define ZZZ_WAKE_PIN (1 << 0)     // Pin change or INT0
+#define ZZZ_WAKE_WDT (1 << 1)     // WDT interrupt
+#define ZZZ_WAKE_ADC (1 << 2)     // ADC conversion complete
+#define ZZZ_WAKE_CLOCKED (1 << 3) // Timer0/1 or USI interrupts, need the I/O clock
+
+// Stops the clock of peripherals: pr are bits of PRR, e.g.
+// (1 << PRADC) | (1 << PRUSI) | (1 << PRTIM1). Their registers keep their
+// values, but can not be written until powered on again. The ADC is disabled
+// before (ADEN), as required
+void zzz_power_off(uint8_t pr);
+
+// Starts the clock of peripherals again, see zzz_power_off()
+void zzz_power_on(uint8_t pr);
+
+// Returns the wake sources (ZZZ_WAKE_*) armed, i.e. interrupts enabled in
+// the peripheral registers. Timers without clock (stopped or powered off) are
+// not counted
+uint8_t zzz_wake_sources(void);
+
+// Returns the deepest sleep mode (SLEEP_MODE_*) that keeps all wake sources
+// (ZZZ_WAKE_*) working
+uint8_t zzz_mode_for(uint8_t wake);
+
+// Sleeps once in the deepest mode for the armed wake sources (see
+// zzz_mode_for()), until any interrupt. With none armed, it never wakes up.
+// Interrupts are enabled right before sleeping. Disable them before checking
+// a flag set by an ISR, so its interrupt can not be missed (as
+// timemeas_sleep_until() does)
+void zzz_sleep_armed(void);
+
+// Power-down sleep (SLEEP_MODE_PWR_DOWN). All clocks stop, including
+// Timer0 (timemeas_now() freezes). Wakes up by e.g. a pin change interrupt.
+// With ZZZ_TIMEMEAS defined (firmwares using timemeas, see Makefile), the
+// WDT keeps time (wakes up every ZZZ_WDT_MAX_MS), and the time slept is
+// merged into timemeas. Also applies to zzz_pins_pressed() and
+// zzz_sleep_pressed()
 void zzz_sleep(void);
 
+// Watchdog timer (WDT) periods [ms], from its own 128kHz oscillator: 16ms
+// (2K cycles) doubling up to 8s (1024K cycles). The oscillator keeps running
+// in power-down (~4uA), but is only accurate to about +-10%
+#define ZZZ_WDT_MIN_MS 16
+#define ZZZ_WDT_MAX_MS 8192
+
+// Power-down sleep for up to ms [ms], timed by WDT interrupts: a coarse
+// clock for periodic wake-ups, e.g. a low-duty animation while asleep.
+// Sleeps in the longest WDT periods that fit, the rest below ZZZ_WDT_MIN_MS
+// is not slept. Stores the time slept [ms] in slept, to be merged into the
+// stopped clock on wake (see timemeas_advance()).
+// Returns 1 if the time was slept, 0 if another interrupt (e.g. pin change)
+// woke up the CPU early. The interrupted WDT period then counts half.
+// Interrupts must be enabled. The WDTON fuse must be unprogrammed.
+uint8_t zzz_sleep_for(uint16_t ms, uint16_t *slept);
+
+// Equal samples (ZZZ_WDT_MIN_MS apart) for pins to count as settled,
+// see zzz_pins_pressed()
+#ifndef ZZZ_WAKE_SAMPLES
+#define ZZZ_WAKE_SAMPLES 3
+#endif
+
+// Samples pins (PINB bits, active low, e.g. buttons with pull-up) every
+// ZZZ_WDT_MIN_MS in power-down, until they read the same ZZZ_WAKE_SAMPLES
+// times in a row (~50ms, longer while bouncing). Returns 1 if any of them
+// is pressed. Interrupts must be enabled
+uint8_t zzz_pins_pressed(uint8_t pins);
+
+// Power-down sleep until one of pins (see zzz_pins_pressed()) is pressed.
+// A press still held on entry must be released first. Wake-ups by bouncing
+// or releasing go straight back to sleep, so no delay is needed before.
+// The pins must be enabled as pin change interrupts
+void zzz_sleep_pressed(uint8_t pins);
+
+// Time spent per state (define ZZZ_STATS, e.g. make ZZZ_STATS=1), to
+// compare the energy of firmwares: with the supply current I[s] of each
+// state s (datasheet or measured), the charge per hour is
+//   Q = sum(ms[s] * I[s]) / sum(ms[s]) * 1h
+// Only counts, sleeping is the same without. Requires timemeas. Idle is
+// counted by timemeas_sleep_until() and zzz_sleep_armed(), power-down by
+// the WDT. Without ZZZ_TIMEMEAS, zzz_sleep() is not timed: only its sleeps
+// are counted, and timemeas_now() excludes them. In ADC noise reduction mode,
+// Timer0 stops: only the sleeps are counted, each lasts about one
+// conversion (e.g. 13 ADC cycles at 125kHz, 0.1ms)
+#define ZZZ_ACTIVE 0
+#define ZZZ_IDLE 1
+#define ZZZ_ADC 2
+#define ZZZ_PWR_DOWN 3
+#define ZZZ_NUM_STATES 4
+
+typedef struct
+{
+    uint32_t ms[ZZZ_NUM_STATES];     // time [ms]
+    uint16_t sleeps[ZZZ_NUM_STATES]; // number of sleeps
+} zzz_stats;
+
+#ifdef ZZZ_STATS
+
+// Counts a sleep of ms [ms] in state
+void zzz_stats_add(uint8_t state, uint32_t ms);
+
+// Copies the counters since init to stats. The active time is the rest of
+// timemeas_now()
+void zzz_stats_get(zzz_stats *stats);
+
+#else
+
+#define zzz_stats_add(state, ms) ((void)0)
+
+#endif
+
 #endif